@@ -0,0 +1,15 @@
+#version 330
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_offset;
+layout(location = 2) in vec3 in_scale;
+layout(location = 3) in vec3 in_color;
+
+out vec4 out_color;
+
+uniform mat4 ortho_transform;
+
+void main() {
+    gl_Position = ortho_transform * vec4(in_position * in_scale + in_offset, 1.0f);
+    out_color = vec4(in_color, 1.0f);
+}
\ No newline at end of file
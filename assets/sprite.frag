@@ -2,9 +2,10 @@
 
 out vec4 Frag_Color;
 in vec4 out_color;
+in vec2 out_texcoord;
 
-uniform sampler2d texture;
+uniform sampler2D atlas;
 
 void main() {
-    Frag_Color = out_color;
+    Frag_Color = out_color * texture(atlas, out_texcoord);
 }
\ No newline at end of file
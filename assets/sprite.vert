@@ -1,15 +1,19 @@
 #version 330
 
 layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_color;
-layout(location = 2) in vec2 in_texcoord;
+layout(location = 1) in vec3 in_offset;
+layout(location = 2) in vec3 in_scale;
+layout(location = 3) in vec3 in_color;
+layout(location = 4) in vec4 in_uv_rect;
 
 out vec4 out_color;
+out vec2 out_texcoord;
 
-uniform mat4 world_transform;
 uniform mat4 ortho_transform;
 
 void main() {
-    gl_Position = ortho_transform * world_transform * vec4(in_position, 1.0f);
+    gl_Position = ortho_transform * vec4(in_position * in_scale + in_offset, 1.0f);
     out_color = vec4(in_color, 1.0f);
+    // The unit quad spans -0.5 to 0.5, which maps onto the atlas region
+    out_texcoord = mix(in_uv_rect.xy, in_uv_rect.zw, in_position.xy + 0.5f);
 }
\ No newline at end of file
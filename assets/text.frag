@@ -0,0 +1,16 @@
+#version 330
+
+out vec4 Frag_Color;
+in vec4 out_color;
+in vec2 out_texcoord;
+
+// Signed distance field, 0.5 on the glyph edge
+uniform sampler2D atlas;
+
+void main() {
+    float distance = texture(atlas, out_texcoord).r;
+    // Antialias across about one screen pixel at any scale
+    float width = fwidth(distance);
+    float coverage = smoothstep(0.5f - width, 0.5f + width, distance);
+    Frag_Color = vec4(out_color.rgb, out_color.a * coverage);
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 330
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec4 in_color;
+layout(location = 2) in vec2 in_texcoord;
+
+out vec4 out_color;
+out vec2 out_texcoord;
+
+uniform mat4 ortho_transform;
+
+void main() {
+    gl_Position = ortho_transform * vec4(in_position, 0.0f, 1.0f);
+    out_color = in_color;
+    out_texcoord = in_texcoord;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Timing shared by the benchmarks
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Mean and tail of a set of samples, e.g. one time per frame
+struct Bench_Stats {
+    double mean = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+inline Bench_Stats summarize(std::vector<double> samples) {
+    Bench_Stats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    for (double sample : samples)
+        stats.mean += sample;
+    stats.mean /= samples.size();
+    stats.p99 = samples[(size_t) (0.99 * (samples.size() - 1))];
+    stats.max = samples.back();
+    return stats;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Writes a directory of a few thousand random-sized TGA sprites, then times
+// decoding them on the job system and packing them into one atlas, and reports
+// how much of the atlas area the images cover. Only the CPU side is measured;
+// no GL context is needed.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Texture_Atlas.hpp"
+#include "Job_System.hpp"
+#include "Bench.hpp"
+
+constexpr int IMAGE_COUNT = 3000;
+constexpr int MIN_SIZE = 8;
+constexpr int MAX_SIZE = 64;
+constexpr int RUNS = 5;
+
+void write_images(const std::string& directory, int count) {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> size(MIN_SIZE, MAX_SIZE);
+    std::uniform_int_distribution<int> channel(0, 255);
+
+    for (int i = 0; i < count; ++i) {
+        Renderer::Image image;
+        image.width = size(random);
+        image.height = size(random);
+        image.pixels.resize((size_t) image.width * image.height * 4);
+        for (uint8_t& value : image.pixels)
+            value = channel(random);
+
+        char name[32];
+        snprintf(name, sizeof(name), "/sprite_%05d.tga", i);
+        Renderer::Save_TGA(directory + name, image);
+    }
+}
+
+int main(int argc, char** argv) {
+    int image_count = argc > 1 ? std::atoi(argv[1]) : IMAGE_COUNT;
+    std::string directory = (std::filesystem::temp_directory_path() / "atlas_bench").string();
+
+    write_images(directory, image_count);
+    Jobs::Initialize();
+
+    std::vector<std::string> names;
+    std::vector<Renderer::Image> images;
+    Renderer::Texture_Atlas atlas;
+
+    double load_ms = 1e9;
+    double pack_ms = 1e9;
+    for (int run = 0; run < RUNS; ++run) {
+        Clock::time_point start = Clock::now();
+        if (!Renderer::Load_Images(directory, names, images)) {
+            printf("failed to load %s\n", directory.c_str());
+            return 1;
+        }
+        load_ms = std::min(load_ms, elapsed_ms(start));
+
+        start = Clock::now();
+        if (!Renderer::Build_Atlas(atlas, names, images, 8192)) {
+            printf("failed to pack %d images\n", image_count);
+            return 1;
+        }
+        pack_ms = std::min(pack_ms, elapsed_ms(start));
+    }
+
+    // Every region must lie inside the atlas without overlapping another
+    int width = atlas.image.width;
+    int height = atlas.image.height;
+    std::vector<uint8_t> covered((size_t) width * height);
+    for (auto& region : atlas.regions) {
+        int x0 = (int) (region.second.min.x * width + 0.5f);
+        int y0 = (int) (region.second.min.y * height + 0.5f);
+        int x1 = (int) (region.second.max.x * width + 0.5f);
+        int y1 = (int) (region.second.max.y * height + 0.5f);
+        if (x0 < 0 || y0 < 0 || x1 > width || y1 > height) {
+            printf("region %s out of bounds\n", region.first.c_str());
+            return 1;
+        }
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                if (covered[(size_t) y * width + x]++) {
+                    printf("region %s overlaps another\n", region.first.c_str());
+                    return 1;
+                }
+            }
+        }
+    }
+
+    printf("images:       %d (%d-%d px), %d threads\n", image_count, MIN_SIZE, MAX_SIZE, Jobs::Thread_Count());
+    printf("load:         %8.2f ms  (%.2f us/image)\n", load_ms, load_ms * 1000.0 / image_count);
+    printf("pack:         %8.2f ms  (%.2f us/image)\n", pack_ms, pack_ms * 1000.0 / image_count);
+    printf("atlas:        %d x %d\n", atlas.image.width, atlas.image.height);
+    printf("efficiency:   %8.1f %%\n", atlas.efficiency * 100.0f);
+    printf("binds/frame:  1 instead of %d\n", image_count);
+
+    Jobs::Shutdown();
+    std::filesystem::remove_all(directory);
+
+    return 0;
+}
\ No newline at end of file
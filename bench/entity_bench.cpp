@@ -0,0 +1,102 @@
+// Compares update + vertex build time of per-object Players against the
+// structure-of-arrays Entity_Store. Both keep a spatial grid of their bounds
+// current as they move, as the store always does, so the two pay the same
+// upkeep. Then compares building the streamed vertices of the store against
+// building its per-instance attributes, the CPU side of the two draw paths.
+// Runs without a GL context.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Entity.hpp"
+#include "Entity_Store.hpp"
+#include "Spatial_Grid.hpp"
+#include "Bench.hpp"
+
+constexpr int ENTITY_COUNT = 100000;
+constexpr int ITERATIONS = 50;
+
+int main(int argc, char** argv) {
+    int entity_count = argc > 1 ? std::atoi(argv[1]) : ENTITY_COUNT;
+    glm::vec3 velocity = { 1.0f, 0.5f, 0.0f };
+
+    // Per-object path
+    std::vector<Player> players;
+    players.reserve(entity_count);
+    for (int i = 0; i < entity_count; ++i) {
+        players.emplace_back(glm::vec3(i % 800, i % 600, 0.0f));
+    }
+
+    // Bounds of a player, as Entity_Store computes them for its grid
+    auto player_bounds = [](const Player& player, glm::vec2& min, glm::vec2& max) {
+        glm::vec2 center(player.transform.position.x, player.transform.position.y);
+        glm::vec2 half_extent = glm::abs(glm::vec2(player.transform.scale.x, player.transform.scale.y)) * 0.5f;
+        min = center - half_extent;
+        max = center + half_extent;
+    };
+    Spatial_Grid player_grid;
+    for (int i = 0; i < entity_count; ++i) {
+        glm::vec2 min, max;
+        player_bounds(players[i], min, max);
+        player_grid.insert(i, min, max);
+    }
+
+    Renderer::Sprite_Batch player_batch;
+    Clock::time_point start = Clock::now();
+    for (int it = 0; it < ITERATIONS; ++it) {
+        player_batch.clear();
+        for (int i = 0; i < entity_count; ++i) {
+            Player& player = players[i];
+            player.transform.position += velocity;
+            glm::vec2 min, max;
+            player_bounds(player, min, max);
+            player_grid.move(i, min, max);
+            player.update_render();
+            player_batch.add(player.sprite);
+        }
+    }
+    double player_ms = elapsed_ms(start) / ITERATIONS;
+
+    // Structure-of-arrays path
+    Entity_Store store;
+    for (int i = 0; i < entity_count; ++i) {
+        store.create(glm::vec3(i % 800, i % 600, 0.0f), glm::vec3(100.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    Renderer::Sprite_Batch store_batch;
+    start = Clock::now();
+    for (int it = 0; it < ITERATIONS; ++it) {
+        // One range, so the positions are written on this thread
+        store.move_parallel(entity_count, [velocity](int first, int count, glm::vec3* positions) {
+            for (int e = first; e < first + count; ++e) {
+                positions[e] += velocity;
+            }
+        });
+        store.build_batch(store_batch);
+    }
+    double store_ms = elapsed_ms(start) / ITERATIONS;
+
+    std::vector<float> vertices;
+    start = Clock::now();
+    for (int it = 0; it < ITERATIONS; ++it) {
+        store.build_vertices_parallel(vertices);
+    }
+    double vertices_ms = elapsed_ms(start) / ITERATIONS;
+
+    std::vector<Renderer::Instance> instances;
+    start = Clock::now();
+    for (int it = 0; it < ITERATIONS; ++it) {
+        store.build_instances_parallel(instances);
+    }
+    double instances_ms = elapsed_ms(start) / ITERATIONS;
+
+    printf("entities: %d\n", entity_count);
+    printf("Player::update_render:  %.3f ms/frame\n", player_ms);
+    printf("Entity_Store:           %.3f ms/frame\n", store_ms);
+    printf("speedup:                %.2fx\n", player_ms / store_ms);
+    printf("streamed vertices:      %.3f ms/frame, %zu KB\n", vertices_ms, vertices.size() * sizeof(float) / 1024);
+    printf("instances:              %.3f ms/frame, %zu KB\n", instances_ms, instances.size() * sizeof(Renderer::Instance) / 1024);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+// Compares the per-frame cost of resolving shaders and VAOs through the old
+// string-keyed std::map against typed handles, at 10k draws per frame. Only
+// the lookups are timed; no GL context is needed.
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Renderer.hpp"
+#include "Bench.hpp"
+
+constexpr int DRAW_COUNT = 10000;
+constexpr int FRAMES = 200;
+
+// Mirrors the old Draw(std::string vao_handle, ...) signature, which copied the
+// name and walked the map on every call
+GLuint __attribute__((noinline)) lookup_by_name(std::map<std::string, GLuint>& map, std::string name) {
+    return map[name];
+}
+
+GLuint __attribute__((noinline)) lookup_by_handle(Renderer::VAO_Handle vao) {
+    return Renderer::Get_VAO(vao);
+}
+
+int main(int argc, char** argv) {
+    int draw_count = argc > 1 ? std::atoi(argv[1]) : DRAW_COUNT;
+
+    std::map<std::string, GLuint> shader_names;
+    std::map<std::string, GLuint> vao_names;
+    std::vector<std::string> draw_names;
+    std::vector<Renderer::VAO_Handle> draw_handles;
+
+    shader_names["color"] = 1;
+    Renderer::shaders.push_back(1);
+    Renderer::shader_pending.push_back(0);
+    Renderer::Shader_Handle color_shader { 0 };
+
+    for (int i = 0; i < draw_count; ++i) {
+        std::string name = "entity_" + std::to_string(i);
+        vao_names[name] = i + 1;
+        draw_names.push_back(name);
+
+        Renderer::vaos.push_back(i + 1);
+        draw_handles.push_back({ (uint32_t) i });
+    }
+
+    GLuint checksum = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        checksum += shader_names["color"];
+        for (int i = 0; i < draw_count; ++i) {
+            checksum += lookup_by_name(vao_names, draw_names[i]);
+        }
+    }
+    double name_ms = elapsed_ms(start) / FRAMES;
+
+    start = Clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        checksum += Renderer::Get_Shader(color_shader);
+        for (int i = 0; i < draw_count; ++i) {
+            checksum += lookup_by_handle(draw_handles[i]);
+        }
+    }
+    double handle_ms = elapsed_ms(start) / FRAMES;
+
+    printf("draws per frame: %d\n", draw_count);
+    printf("std::map<std::string>:  %.4f ms/frame  (%.1f ns/lookup)\n", name_ms, name_ms * 1e6 / draw_count);
+    printf("typed handles:          %.4f ms/frame  (%.1f ns/lookup)\n", handle_ms, handle_ms * 1e6 / draw_count);
+    printf("speedup:                %.1fx\n", name_ms / handle_ms);
+    printf("checksum: %u\n", checksum);
+
+    return 0;
+}
\ No newline at end of file
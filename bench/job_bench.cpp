@@ -0,0 +1,59 @@
+// Measures how entity update and vertex build scale across job system thread
+// counts. Runs without a GL context.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Entity_Store.hpp"
+#include "Job_System.hpp"
+#include "Bench.hpp"
+
+constexpr int ENTITY_COUNT = 1000000;
+constexpr int ITERATIONS = 20;
+
+int main(int argc, char** argv) {
+    int entity_count = argc > 1 ? std::atoi(argv[1]) : ENTITY_COUNT;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    Entity_Store store;
+    for (int i = 0; i < entity_count; ++i) {
+        store.create(glm::vec3(i % 800, i % 600, 0.0f), glm::vec3(10.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    std::vector<float> stream;
+    glm::vec3 velocity = { 1.0f, 0.5f, 0.0f };
+
+    printf("entities: %d\n", entity_count);
+    printf("%8s %12s %9s\n", "threads", "ms/frame", "speedup");
+
+    double single_ms = 0.0;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        // One thread is the serial baseline: no workers, every job inline
+        Jobs::Initialize(threads - 1);
+
+        // Warm up so the stream is allocated and pages are touched
+        store.build_vertices_parallel(stream);
+
+        Clock::time_point start = Clock::now();
+        for (int it = 0; it < ITERATIONS; ++it) {
+            store.move_parallel(4096, [velocity](int first, int count, glm::vec3* positions) {
+                for (int e = first; e < first + count; ++e) {
+                    positions[e] += velocity;
+                }
+            });
+            store.build_vertices_parallel(stream);
+        }
+        double frame_ms = elapsed_ms(start) / ITERATIONS;
+        if (threads == 1)
+            single_ms = frame_ms;
+
+        printf("%8d %12.3f %8.2fx\n", threads, frame_ms, single_ms / frame_ms);
+
+        Jobs::Shutdown();
+    }
+
+    return 0;
+}
\ No newline at end of file
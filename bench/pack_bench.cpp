@@ -0,0 +1,257 @@
+// Saves a 1M entity scene as JSON text and as an asset pack, then compares
+// loading it with a straightforward JSON loader (whole file into a string,
+// parsed into a tree of values, then copied into arrays) against mapping the
+// pack and reading the arrays in place. Also times filling an Entity_Store
+// from the pack. Files are written to the temp directory and removed after.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Asset_Pack.hpp"
+#include "Entity_Store.hpp"
+#include "Bench.hpp"
+
+constexpr int ENTITY_COUNT = 1000000;
+constexpr int SPRITE_COUNT = 16;
+constexpr int RUNS = 3;
+
+struct Scene {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::vec3> tints;
+    std::vector<uint32_t> sprites;
+    std::vector<std::string> sprite_names;
+};
+
+// ================================
+// JSON text baseline
+// ================================
+struct Json_Value {
+    enum Type { NUMBER, STRING, ARRAY, OBJECT } type = NUMBER;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json_Value> array;
+    std::map<std::string, Json_Value> object;
+};
+
+struct Json_Parser {
+    const char* cursor;
+
+    void skip_space() {
+        while (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')
+            cursor++;
+    }
+
+    std::string parse_string() {
+        std::string result;
+        cursor++;
+        while (*cursor && *cursor != '"')
+            result += *cursor++;
+        cursor++;
+        return result;
+    }
+
+    Json_Value parse() {
+        skip_space();
+        Json_Value value;
+        if (*cursor == '{') {
+            value.type = Json_Value::OBJECT;
+            cursor++;
+            skip_space();
+            while (*cursor && *cursor != '}') {
+                skip_space();
+                std::string key = parse_string();
+                skip_space();
+                cursor++;
+                value.object[key] = parse();
+                skip_space();
+                if (*cursor == ',')
+                    cursor++;
+            }
+            cursor++;
+        }
+        else if (*cursor == '[') {
+            value.type = Json_Value::ARRAY;
+            cursor++;
+            skip_space();
+            while (*cursor && *cursor != ']') {
+                value.array.push_back(parse());
+                skip_space();
+                if (*cursor == ',')
+                    cursor++;
+                skip_space();
+            }
+            cursor++;
+        }
+        else if (*cursor == '"') {
+            value.type = Json_Value::STRING;
+            value.string = parse_string();
+        }
+        else {
+            char* end;
+            value.number = std::strtod(cursor, &end);
+            cursor = end;
+        }
+        return value;
+    }
+};
+
+void save_json(const std::string& filename, const Scene& scene) {
+    FILE* file = fopen(filename.c_str(), "w");
+    fprintf(file, "{\n\"sprites\": [");
+    for (size_t n = 0; n < scene.sprite_names.size(); ++n)
+        fprintf(file, "%s\"%s\"", n ? ", " : "", scene.sprite_names[n].c_str());
+    fprintf(file, "],\n\"entities\": [\n");
+
+    // %.9g round-trips every float exactly
+    for (size_t e = 0; e < scene.positions.size(); ++e) {
+        const glm::vec3& p = scene.positions[e];
+        const glm::vec3& s = scene.scales[e];
+        const glm::vec3& t = scene.tints[e];
+        fprintf(file, "{\"position\": [%.9g, %.9g, %.9g], \"scale\": [%.9g, %.9g, %.9g], \"tint\": [%.9g, %.9g, %.9g], \"sprite\": %u}%s\n",
+            p.x, p.y, p.z, s.x, s.y, s.z, t.x, t.y, t.z, scene.sprites[e], e + 1 < scene.positions.size() ? "," : "");
+    }
+    fprintf(file, "]\n}\n");
+    fclose(file);
+}
+
+glm::vec3 to_vec3(const Json_Value& value) {
+    return glm::vec3((float) value.array[0].number, (float) value.array[1].number, (float) value.array[2].number);
+}
+
+void load_json(const std::string& filename, Scene& scene) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+
+    Json_Parser parser { text.c_str() };
+    Json_Value root = parser.parse();
+
+    scene = Scene {};
+    for (const Json_Value& name : root.object["sprites"].array)
+        scene.sprite_names.push_back(name.string);
+
+    const std::vector<Json_Value>& entities = root.object["entities"].array;
+    for (const Json_Value& entity : entities) {
+        scene.positions.push_back(to_vec3(entity.object.at("position")));
+        scene.scales.push_back(to_vec3(entity.object.at("scale")));
+        scene.tints.push_back(to_vec3(entity.object.at("tint")));
+        scene.sprites.push_back((uint32_t) entity.object.at("sprite").number);
+    }
+}
+
+bool same_bits(const void* a, const void* b, size_t size) {
+    return std::memcmp(a, b, size) == 0;
+}
+
+int main(int argc, char** argv) {
+    int entity_count = argc > 1 ? std::atoi(argv[1]) : ENTITY_COUNT;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(0.0f, 20000.0f);
+    std::uniform_real_distribution<float> size(4.0f, 32.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> sprite(0, SPRITE_COUNT - 1);
+
+    Scene scene;
+    for (int n = 0; n < SPRITE_COUNT; ++n)
+        scene.sprite_names.push_back("sprite_" + std::to_string(n));
+    for (int e = 0; e < entity_count; ++e) {
+        float s = size(random);
+        scene.positions.push_back(glm::vec3(coordinate(random), coordinate(random), unit(random)));
+        scene.scales.push_back(glm::vec3(s, s, 1.0f));
+        scene.tints.push_back(glm::vec3(unit(random), unit(random), unit(random)));
+        scene.sprites.push_back(sprite(random));
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string json_file = (directory / "pack_bench_scene.json").string();
+    std::string pack_file = (directory / "pack_bench_scene.pack").string();
+
+    Clock::time_point start = Clock::now();
+    save_json(json_file, scene);
+    double json_save_ms = elapsed_ms(start);
+
+    start = Clock::now();
+    Asset_Pack::Pack_Writer writer;
+    Asset_Pack::Add_Scene(writer, "scene", entity_count, scene.positions.data(), scene.scales.data(), scene.tints.data(),
+                          scene.sprites.data(), scene.sprite_names);
+    if (!Asset_Pack::Write_Pack(writer, pack_file))
+        return 1;
+    double pack_save_ms = elapsed_ms(start);
+
+    // Best of RUNS; the files stay in the page cache between runs
+    double json_load_ms = 1e30;
+    double pack_open_ms = 1e30;
+    double pack_read_ms = 1e30;
+    double store_ms = 1e30;
+    bool match = true;
+    for (int run = 0; run < RUNS; ++run) {
+        Scene loaded;
+        start = Clock::now();
+        load_json(json_file, loaded);
+        json_load_ms = std::min(json_load_ms, elapsed_ms(start));
+
+        Asset_Pack::Pack pack;
+        Asset_Pack::Scene_View view;
+        start = Clock::now();
+        bool opened = Asset_Pack::Open(pack, pack_file) && Asset_Pack::Get_Scene(pack, "scene", view);
+        pack_open_ms = std::min(pack_open_ms, elapsed_ms(start));
+        if (!opened)
+            return 1;
+
+        // Touching every value faults in the mapped pages
+        start = Clock::now();
+        double checksum = 0.0;
+        for (uint32_t e = 0; e < view.entity_count; ++e)
+            checksum += view.positions[e].x + view.scales[e].x + view.tints[e].x + view.sprites[e];
+        pack_read_ms = std::min(pack_read_ms, elapsed_ms(start));
+        if (checksum < 0.0)
+            printf("%f\n", checksum);
+
+        match = match && view.entity_count == (uint32_t) entity_count && loaded.positions.size() == (size_t) entity_count
+            && same_bits(view.positions, loaded.positions.data(), entity_count * sizeof(glm::vec3))
+            && same_bits(view.scales, loaded.scales.data(), entity_count * sizeof(glm::vec3))
+            && same_bits(view.tints, loaded.tints.data(), entity_count * sizeof(glm::vec3))
+            && same_bits(view.sprites, loaded.sprites.data(), entity_count * sizeof(uint32_t))
+            && view.sprite_name_count == SPRITE_COUNT && loaded.sprite_names[3] == view.sprite_name(3);
+
+        Entity_Store store;
+        start = Clock::now();
+        store.load(view);
+        store_ms = std::min(store_ms, elapsed_ms(start));
+
+        Asset_Pack::Close(pack);
+    }
+
+    size_t json_bytes = std::filesystem::file_size(json_file);
+    size_t pack_bytes = std::filesystem::file_size(pack_file);
+    std::filesystem::remove(json_file);
+    std::filesystem::remove(pack_file);
+
+    if (!match) {
+        printf("MISMATCH: JSON and pack scenes differ\n");
+        return 1;
+    }
+
+    printf("entities: %d\n", entity_count);
+    printf("%-22s %10.1f MB  save %8.1f ms  load %10.3f ms\n", "json", json_bytes / 1.0e6, json_save_ms, json_load_ms);
+    printf("%-22s %10.1f MB  save %8.1f ms  load %10.3f ms  (%.0fx faster)\n", "pack open + view", pack_bytes / 1.0e6, pack_save_ms,
+        pack_open_ms, json_load_ms / pack_open_ms);
+    printf("%-22s %32s %10.3f ms  (%.0fx faster)\n", "pack + read all", "", pack_open_ms + pack_read_ms,
+        json_load_ms / (pack_open_ms + pack_read_ms));
+    printf("%-22s %32s %10.3f ms\n", "Entity_Store::load", "", store_ms);
+
+    return 0;
+}
\ No newline at end of file
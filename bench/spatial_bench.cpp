@@ -0,0 +1,153 @@
+// Pans an 800x600 camera across a world of 1M entities much larger than the
+// view and compares building every entity, culling by testing every entity,
+// and culling through the spatial grid. Also times incremental moves, mouse
+// picks and box selections. Runs without a GL context.
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Entity_Store.hpp"
+#include "Job_System.hpp"
+#include "Bench.hpp"
+
+constexpr int ENTITY_COUNT = 1000000;
+constexpr float WORLD_SIZE = 20000.0f;
+constexpr float VIEW_WIDTH = 800.0f;
+constexpr float VIEW_HEIGHT = 600.0f;
+constexpr int FRAMES = 300;
+constexpr int FULL_BUILD_FRAMES = 10;
+// Entities moved per frame in the incremental update test
+constexpr int MOVES_PER_FRAME = 10000;
+constexpr int PICKS = 10000;
+
+// Camera position on a diagonal pan across the world
+glm::vec2 camera_at(int frame) {
+    float t = (float) frame / FRAMES;
+    return glm::vec2(t * (WORLD_SIZE - VIEW_WIDTH), t * (WORLD_SIZE - VIEW_HEIGHT) * 0.5f);
+}
+
+int main(int argc, char** argv) {
+    int entity_count = argc > 1 ? std::atoi(argv[1]) : ENTITY_COUNT;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(0.0f, WORLD_SIZE);
+    std::uniform_real_distribution<float> size(4.0f, 32.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    Entity_Store store;
+    std::vector<Entity_Handle> handles;
+    handles.reserve(entity_count);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < entity_count; ++i) {
+        float s = size(random);
+        handles.push_back(store.create(glm::vec3(coordinate(random), coordinate(random), unit(random)),
+                                       glm::vec3(s, s, 1.0f), glm::vec3(unit(random), unit(random), unit(random))));
+    }
+    double create_ms = elapsed_ms(start);
+
+    Jobs::Initialize();
+
+    std::vector<float> stream;
+    std::vector<uint32_t> brute_visible;
+
+    // Everything, as before culling
+    store.build_vertices_parallel(stream);
+    start = Clock::now();
+    for (int frame = 0; frame < FULL_BUILD_FRAMES; ++frame)
+        store.build_vertices_parallel(stream);
+    double full_ms = elapsed_ms(start) / FULL_BUILD_FRAMES;
+
+    // Test every entity against the view
+    size_t brute_total = 0;
+    start = Clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        glm::vec2 view_min = camera_at(frame);
+        glm::vec2 view_max = view_min + glm::vec2(VIEW_WIDTH, VIEW_HEIGHT);
+
+        brute_visible.clear();
+        for (int e = 0; e < store.size(); ++e) {
+            glm::vec3 p = store.position(e);
+            glm::vec3 h = store.scale(e) * 0.5f;
+            if (p.x + h.x >= view_min.x && p.x - h.x <= view_max.x && p.y + h.y >= view_min.y && p.y - h.y <= view_max.y)
+                brute_visible.push_back(e);
+        }
+        brute_total += brute_visible.size();
+    }
+    double brute_ms = elapsed_ms(start) / FRAMES;
+
+    // Spatial grid
+    size_t grid_total = 0;
+    double cull_ms = 0.0;
+    double build_ms = 0.0;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        glm::vec2 view_min = camera_at(frame);
+        glm::vec2 view_max = view_min + glm::vec2(VIEW_WIDTH, VIEW_HEIGHT);
+
+        start = Clock::now();
+        store.cull(view_min, view_max);
+        cull_ms += elapsed_ms(start);
+
+        start = Clock::now();
+        store.build_visible_parallel(stream);
+        build_ms += elapsed_ms(start);
+
+        grid_total += store.visible.size();
+    }
+    cull_ms /= FRAMES;
+    build_ms /= FRAMES;
+
+    if (grid_total != brute_total) {
+        printf("MISMATCH: grid found %zu entities, brute force %zu\n", grid_total, brute_total);
+        return 1;
+    }
+
+    // Incremental moves of random entities by a few pixels
+    std::uniform_int_distribution<int> pick_entity(0, entity_count - 1);
+    std::uniform_real_distribution<float> step(-8.0f, 8.0f);
+    start = Clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        for (int m = 0; m < MOVES_PER_FRAME; ++m) {
+            Entity_Handle handle = handles[pick_entity(random)];
+            uint32_t index = store.index_of(handle);
+            glm::vec3 position = store.position(index) + glm::vec3(step(random), step(random), 0.0f);
+            store.set_transform(handle, position, store.scale(index));
+        }
+    }
+    double move_ms = elapsed_ms(start) / FRAMES;
+
+    // Mouse picks and 800x600 box selections at random points
+    int picked = 0;
+    start = Clock::now();
+    for (int p = 0; p < PICKS; ++p) {
+        if (store.pick(glm::vec2(coordinate(random), coordinate(random))).slot != UINT32_MAX)
+            picked++;
+    }
+    double pick_us = elapsed_ms(start) * 1000.0 / PICKS;
+
+    std::vector<Entity_Handle> selection;
+    start = Clock::now();
+    for (int p = 0; p < PICKS; ++p) {
+        glm::vec2 corner(coordinate(random), coordinate(random));
+        selection.clear();
+        store.select(corner, corner + glm::vec2(VIEW_WIDTH, VIEW_HEIGHT), selection);
+    }
+    double select_us = elapsed_ms(start) * 1000.0 / PICKS;
+
+    printf("entities:          %d in %.0fx%.0f world, %d threads\n", entity_count, WORLD_SIZE, WORLD_SIZE, Jobs::Thread_Count());
+    printf("create:            %10.2f ms\n", create_ms);
+    printf("visible/frame:     %10.1f\n", (double) grid_total / FRAMES);
+    printf("build all:         %10.3f ms/frame\n", full_ms);
+    printf("brute force cull:  %10.3f ms/frame\n", brute_ms);
+    printf("grid cull:         %10.3f ms/frame\n", cull_ms);
+    printf("grid cull + build: %10.3f ms/frame  (%.1fx faster than build all)\n", cull_ms + build_ms, full_ms / (cull_ms + build_ms));
+    printf("move %d:        %10.3f ms/frame\n", MOVES_PER_FRAME, move_ms);
+    printf("pick:              %10.2f us  (%d of %d hit)\n", pick_us, picked, PICKS);
+    printf("box select:        %10.2f us\n", select_us);
+
+    Jobs::Shutdown();
+
+    return 0;
+}
\ No newline at end of file
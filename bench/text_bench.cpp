@@ -0,0 +1,124 @@
+// Times building the glyph atlas, then the CPU side of drawing a screen of
+// paragraphs: laying text out from scratch, fetching cached layouts, and
+// writing the glyph quads of a batch. Rates are in glyphs per millisecond.
+// Only the CPU side is measured; no GL context is needed, and the GPU cost of
+// the text shader shows up in `program --headless --text N`.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Text.hpp"
+#include "Bench.hpp"
+
+constexpr int PARAGRAPH_COUNT = 200;
+constexpr int PARAGRAPH_LENGTH = 500;
+constexpr int RUNS = 20;
+
+// Random words of printable characters, a few lines broken explicitly
+std::string make_paragraph(std::mt19937& random) {
+    std::uniform_int_distribution<int> word_length(1, 10);
+    std::uniform_int_distribution<int> character('!', '~');
+    std::uniform_int_distribution<int> line_break(0, 15);
+
+    std::string text;
+    while ((int) text.size() < PARAGRAPH_LENGTH) {
+        int length = word_length(random);
+        for (int i = 0; i < length; ++i)
+            text += (char) character(random);
+        text += line_break(random) == 0 ? '\n' : ' ';
+    }
+    text.resize(PARAGRAPH_LENGTH);
+    return text;
+}
+
+int main() {
+    Clock::time_point start = Clock::now();
+    Renderer::Glyph_Atlas atlas;
+    Renderer::Build_Glyph_Atlas(atlas);
+    printf("glyph atlas: %dx%d, %d glyphs, built in %.2f ms\n", atlas.width, atlas.height, Renderer::GLYPH_COUNT, elapsed_ms(start));
+
+    std::mt19937 random(1234);
+    std::vector<Renderer::Text> texts(PARAGRAPH_COUNT);
+    for (int i = 0; i < PARAGRAPH_COUNT; ++i) {
+        texts[i].string = make_paragraph(random);
+        texts[i].position = { 0.0f, 600.0f };
+        texts[i].size = 12.0f;
+        texts[i].max_width = 780.0f;
+    }
+
+    Renderer::Text_Layout layout;
+    size_t glyph_count = 0;
+    for (const Renderer::Text& text : texts) {
+        Renderer::Layout_Text(text.string, text.size, text.max_width, layout);
+        glyph_count += layout.quads.size();
+    }
+    printf("%d paragraphs of %d characters, %zu glyph quads per frame, %d runs\n\n", PARAGRAPH_COUNT, PARAGRAPH_LENGTH, glyph_count, RUNS);
+
+    double layout_ms = 1e30;
+    for (int run = 0; run < RUNS; ++run) {
+        start = Clock::now();
+        for (const Renderer::Text& text : texts)
+            Renderer::Layout_Text(text.string, text.size, text.max_width, layout);
+        layout_ms = std::min(layout_ms, elapsed_ms(start));
+    }
+
+    Renderer::Text_Cache cache;
+    for (const Renderer::Text& text : texts)
+        cache.get(text.string, text.size, text.max_width);
+    double cached_ms = 1e30;
+    size_t checksum = 0;
+    for (int run = 0; run < RUNS; ++run) {
+        start = Clock::now();
+        for (const Renderer::Text& text : texts)
+            checksum += cache.get(text.string, text.size, text.max_width).quads.size();
+        cache.end_frame();
+        cached_ms = std::min(cached_ms, elapsed_ms(start));
+    }
+
+    // Vertices of every paragraph into one batch, as drawn in a single call
+    Renderer::Sprite_Batch batch;
+    batch.buffer.stream.reserve(glyph_count * 16);
+    double vertices_ms = 1e30;
+    for (int run = 0; run < RUNS; ++run) {
+        start = Clock::now();
+        batch.clear();
+        for (const Renderer::Text& text : texts)
+            Renderer::Add_Layout(batch, atlas, cache.get(text.string, text.size, text.max_width), text.position, text.color);
+        vertices_ms = std::min(vertices_ms, elapsed_ms(start));
+        cache.end_frame();
+    }
+
+    // A frame with the cache against one laying every string out again
+    double frame_ms = 1e30;
+    double uncached_frame_ms = 1e30;
+    for (int run = 0; run < RUNS; ++run) {
+        start = Clock::now();
+        batch.clear();
+        for (const Renderer::Text& text : texts)
+            Renderer::Add_Text(batch, cache, atlas, text);
+        cache.end_frame();
+        frame_ms = std::min(frame_ms, elapsed_ms(start));
+
+        start = Clock::now();
+        batch.clear();
+        for (const Renderer::Text& text : texts) {
+            Renderer::Layout_Text(text.string, text.size, text.max_width, layout);
+            Renderer::Add_Layout(batch, atlas, layout, text.position, text.color);
+        }
+        uncached_frame_ms = std::min(uncached_frame_ms, elapsed_ms(start));
+    }
+
+    printf("%-24s %10s %14s\n", "stage", "ms", "glyphs/ms");
+    printf("%-24s %10.3f %14.0f\n", "layout", layout_ms, glyph_count / layout_ms);
+    printf("%-24s %10.3f %14.0f\n", "cached layout", cached_ms, glyph_count / cached_ms);
+    printf("%-24s %10.3f %14.0f\n", "vertices", vertices_ms, glyph_count / vertices_ms);
+    printf("%-24s %10.3f %14.0f\n", "frame, uncached", uncached_frame_ms, glyph_count / uncached_frame_ms);
+    printf("%-24s %10.3f %14.0f\n", "frame, cached", frame_ms, glyph_count / frame_ms);
+    printf("\n%d quads in one batch, %zu bytes of vertices, cache hits %d, misses %d (checksum %zu)\n",
+        batch.sprite_count, batch.buffer.stream.size() * sizeof(float), cache.hits, cache.misses, checksum);
+
+    return 0;
+}
\ No newline at end of file
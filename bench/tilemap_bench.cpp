@@ -0,0 +1,130 @@
+// CPU side of a 4096x4096 tilemap: building every chunk mesh once, frames
+// scrolling an 800x600 view across the map while chunks coming into view are
+// built on the job system, and the time from a tile edit until its chunk's
+// mesh is rebuilt. Streaming every visible tile each frame, the way entity
+// sprites are drawn, is timed for comparison. No GL context is needed; the
+// upload and draw side shows up in `program --headless --tilemap 4096`.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Tilemap.hpp"
+#include "Job_System.hpp"
+#include "Bench.hpp"
+
+constexpr int MAP_SIZE = 4096;
+constexpr float TILE_SIZE = 8.0f;
+constexpr float VIEW_WIDTH = 800.0f;
+constexpr float VIEW_HEIGHT = 600.0f;
+constexpr float SCROLL_SPEED = 3.0f;
+constexpr int FRAMES = 2000;
+constexpr int EDITS = 2000;
+
+void fill_map(Renderer::Tilemap& map) {
+    std::mt19937 random(1234);
+    map.tile_size = TILE_SIZE;
+    map.resize(MAP_SIZE, MAP_SIZE);
+    map.palette.push_back(0);
+    for (int color = 1; color < 16; ++color)
+        map.palette.push_back(Vertex_Kernel::Pack_Color(glm::vec3(color / 16.0f, 0.5f, 1.0f - color / 16.0f)));
+
+    // One tile in four is empty
+    std::uniform_int_distribution<int> tile_id(-4, 15);
+    for (uint16_t& tile : map.tiles)
+        tile = (uint16_t) std::max(tile_id(random), 0);
+}
+
+glm::vec2 view_at(int frame) {
+    float range = MAP_SIZE * TILE_SIZE - VIEW_WIDTH;
+    return glm::vec2(std::fmod(frame * SCROLL_SPEED, range), std::fmod(frame * SCROLL_SPEED * 0.5f, range));
+}
+
+int main() {
+    Jobs::Initialize();
+
+    Renderer::Tilemap map;
+    fill_map(map);
+    int chunk_count = map.chunks_x * map.chunks_y;
+    printf("%dx%d tiles, %d chunks of %dx%d, %d threads\n\n", map.width, map.height, chunk_count,
+        Renderer::CHUNK_TILES, Renderer::CHUNK_TILES, Jobs::Thread_Count());
+
+    // Every mesh of the map, once on one thread and once on all of them,
+    // after a first pass so neither run pays for allocating the meshes
+    std::vector<std::vector<float>> meshes(chunk_count);
+    size_t quad_count = 0;
+    for (int chunk = 0; chunk < chunk_count; ++chunk)
+        quad_count += Renderer::Build_Chunk_Mesh(map, chunk, meshes[chunk]);
+
+    Clock::time_point start = Clock::now();
+    for (int chunk = 0; chunk < chunk_count; ++chunk)
+        Renderer::Build_Chunk_Mesh(map, chunk, meshes[chunk]);
+    double serial_ms = elapsed_ms(start);
+
+    start = Clock::now();
+    Jobs::Parallel_For(chunk_count, 16, [&map, &meshes](int first, int count) {
+        for (int chunk = first; chunk < first + count; ++chunk)
+            Renderer::Build_Chunk_Mesh(map, chunk, meshes[chunk]);
+    });
+    double parallel_ms = elapsed_ms(start);
+    printf("build all meshes: %.1f ms serial, %.1f ms parallel, %zu quads, %.0f MB\n",
+        serial_ms, parallel_ms, quad_count, quad_count * Vertex_Kernel::QUAD_SIZE * sizeof(float) / 1e6);
+    meshes.clear();
+    meshes.shrink_to_fit();
+
+    // Scrolling with chunks built as they come into view, then over the
+    // same path again with every mesh cached
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<double> frame_times;
+        size_t visible_total = 0;
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            glm::vec2 view_min = view_at(frame);
+            start = Clock::now();
+            Renderer::Update_Tilemap(map, view_min, view_min + glm::vec2(VIEW_WIDTH, VIEW_HEIGHT));
+            Jobs::Wait(map.builds);
+            frame_times.push_back(elapsed_ms(start));
+            visible_total += map.visible.size();
+        }
+        Bench_Stats stats = summarize(frame_times);
+        printf("%-26s %.4f ms mean, %.4f ms p99, %.4f ms max, %.1f chunks in view\n",
+            pass == 0 ? "scroll, building:" : "scroll, cached:", stats.mean, stats.p99, stats.max, (double) visible_total / FRAMES);
+    }
+
+    // Every visible tile written again each frame instead
+    std::vector<double> stream_times;
+    std::vector<float> stream;
+    for (int frame = 0; frame < FRAMES; frame += 10) {
+        glm::vec2 view_min = view_at(frame);
+        Renderer::Update_Tilemap(map, view_min, view_min + glm::vec2(VIEW_WIDTH, VIEW_HEIGHT));
+        Jobs::Wait(map.builds);
+        start = Clock::now();
+        for (uint32_t chunk : map.visible)
+            Renderer::Build_Chunk_Mesh(map, chunk, stream);
+        stream_times.push_back(elapsed_ms(start));
+    }
+    Bench_Stats stream_stats = summarize(stream_times);
+    printf("%-26s %.4f ms mean, %.4f ms p99, %.4f ms max\n", "stream visible tiles:", stream_stats.mean, stream_stats.p99, stream_stats.max);
+
+    // A tile in view edited, then the frame's update until its mesh is built
+    std::mt19937 random(99);
+    std::uniform_real_distribution<float> offset(0.0f, 1.0f);
+    std::vector<double> edit_times;
+    for (int edit = 0; edit < EDITS; ++edit) {
+        glm::vec2 view_min = view_at(edit);
+        int x = (int) ((view_min.x + offset(random) * VIEW_WIDTH) / TILE_SIZE);
+        int y = (int) ((view_min.y + offset(random) * VIEW_HEIGHT) / TILE_SIZE);
+
+        start = Clock::now();
+        map.set(x, y, map.get(x, y) % 15 + 1);
+        Renderer::Update_Tilemap(map, view_min, view_min + glm::vec2(VIEW_WIDTH, VIEW_HEIGHT));
+        Jobs::Wait(map.builds);
+        edit_times.push_back(elapsed_ms(start));
+    }
+    Bench_Stats edit_stats = summarize(edit_times);
+    printf("%-26s %.4f ms mean, %.4f ms p99, %.4f ms max\n", "edit to rebuilt mesh:", edit_stats.mean, edit_stats.p99, edit_stats.max);
+
+    Jobs::Shutdown();
+    return 0;
+}
\ No newline at end of file
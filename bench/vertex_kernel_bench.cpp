@@ -0,0 +1,72 @@
+// Times every Vertex_Kernel path against the glm matrix path that
+// Sprite::update_buffer used. Runs without a GL context; that every path
+// produces the same bits is checked by tests/vertex_kernel_test.
+// Also prints the bytes per quad against the old layout of six vertices with
+// 3D float positions and float RGB tints.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Vertex_Kernel.hpp"
+#include "Bench.hpp"
+#include "../tests/Vertex_Reference.hpp"
+
+constexpr int QUAD_COUNT = 100000;
+constexpr int ITERATIONS = 100;
+constexpr int OLD_QUAD_BYTES = 6 * 6 * sizeof(float);
+
+int main(int argc, char** argv) {
+    int quad_count = argc > 1 ? std::atoi(argv[1]) : QUAD_COUNT;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coordinate(-4000.0f, 4000.0f);
+    std::uniform_real_distribution<float> size(0.1f, 300.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<glm::vec3> positions(quad_count);
+    std::vector<glm::vec3> scales(quad_count);
+    std::vector<glm::vec3> tints(quad_count);
+    for (int q = 0; q < quad_count; ++q) {
+        positions[q] = { coordinate(rng), coordinate(rng), unit(rng) * -50.0f };
+        scales[q] = { size(rng), size(rng), 1.0f };
+        // Slightly out of range so clamping is exercised
+        tints[q] = { unit(rng) * 1.2f - 0.1f, unit(rng) * 1.2f - 0.1f, unit(rng) * 1.2f - 0.1f };
+    }
+
+    std::vector<float> reference(quad_count * Vertex_Kernel::QUAD_SIZE);
+    std::vector<float> output(reference.size());
+
+    Clock::time_point start = Clock::now();
+    for (int it = 0; it < ITERATIONS; ++it) {
+        Transform_Quads_Glm(positions.data(), scales.data(), tints.data(), quad_count, reference.data());
+    }
+    double glm_ms = elapsed_ms(start) / ITERATIONS;
+
+    int quad_bytes = Vertex_Kernel::QUAD_SIZE * sizeof(float);
+    printf("quads: %d\n", quad_count);
+    printf("bytes/quad: %d (was %d, %.1fx smaller)\n", quad_bytes, OLD_QUAD_BYTES, (double) OLD_QUAD_BYTES / quad_bytes);
+    printf("%-8s %8.3f ms\n", "glm", glm_ms);
+
+    const Vertex_Kernel::Path paths[] = { Vertex_Kernel::Path::SCALAR, Vertex_Kernel::Path::SSE, Vertex_Kernel::Path::AVX2 };
+    for (Vertex_Kernel::Path path : paths) {
+        Vertex_Kernel::Set_Path(path);
+        if (Vertex_Kernel::Active_Path() != path) {
+            printf("%-8s unsupported\n", Vertex_Kernel::Path_Name(path));
+            continue;
+        }
+
+        std::fill(output.begin(), output.end(), 0.0f);
+        start = Clock::now();
+        for (int it = 0; it < ITERATIONS; ++it) {
+            Vertex_Kernel::Transform_Quads(positions.data(), scales.data(), tints.data(), quad_count, output.data());
+        }
+        double path_ms = elapsed_ms(start) / ITERATIONS;
+
+        printf("%-8s %8.3f ms  %5.2fx\n", Vertex_Kernel::Path_Name(path), path_ms, glm_ms / path_ms);
+    }
+
+    return 0;
+}
\ No newline at end of file
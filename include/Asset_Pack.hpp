@@ -0,0 +1,166 @@
+#ifndef ASSET_PACK_HPP
+#define ASSET_PACK_HPP
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary pack of scenes, shaders and textures that is memory mapped and read
+// in place. Layout, little-endian:
+//
+//   Header          64 bytes, at offset 0
+//   Section table   section_count entries of 64 bytes, at table_offset
+//   Sections        each at a multiple of SECTION_ALIGNMENT from the start
+//
+// Offsets in the header and table are from the start of the file; offsets
+// inside a section are from the start of that section. Every array is aligned
+// for its element type, so mapped data is used through plain pointers. Packs
+// are built by tools/pack_builder or Pack_Writer.
+namespace Asset_Pack {
+    constexpr char MAGIC[4] = { 'P', 'A', 'C', 'K' };
+    // Bumped whenever the layout changes; packs of other versions are rejected
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t SECTION_ALIGNMENT = 64;
+    constexpr int MAX_NAME_LENGTH = 40;
+    // Scene entities without a sprite
+    constexpr uint32_t NO_SPRITE = UINT32_MAX;
+    // Scene entities without a physics body
+    constexpr float NO_BODY = -1.0f;
+
+    enum Section_Type : uint32_t {
+        SECTION_SCENE = 1,
+        // Shader source text, named by file, e.g. "color.vert"
+        SECTION_SHADER = 2,
+        SECTION_TEXTURE = 3,
+        // Physics bodies of the scene section with the same name
+        SECTION_BODIES = 4,
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t section_count;
+        uint32_t reserved;
+        uint64_t table_offset;
+        uint64_t file_size;
+        uint8_t padding[32];
+    };
+
+    struct Section {
+        char name[MAX_NAME_LENGTH];
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // Start of a scene section, followed by its arrays
+    struct Scene_Header {
+        uint32_t entity_count;
+        uint32_t sprite_name_count;
+        uint64_t positions_offset;
+        uint64_t scales_offset;
+        uint64_t tints_offset;
+        // One index into the sprite names per entity, or NO_SPRITE
+        uint64_t sprites_offset;
+        // sprite_name_count offsets into the name data, each name NUL-terminated
+        uint64_t name_offsets_offset;
+        uint64_t names_offset;
+    };
+
+    // Start of a bodies section, followed by one float per scene entity: the
+    // mass of a box body the size of the entity's quad, 0 for a static body,
+    // or NO_BODY
+    struct Bodies_Header {
+        uint32_t entity_count;
+        uint32_t reserved;
+        uint64_t masses_offset;
+    };
+
+    // Start of a texture section, followed by the RGBA8 pixels, bottom row first
+    struct Texture_Header {
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static_assert(sizeof(Header) == 64, "pack header must stay 64 bytes");
+    static_assert(sizeof(Section) == 64, "section entry must stay 64 bytes");
+    static_assert(sizeof(glm::vec3) == 12, "scene arrays store tightly packed vec3");
+
+    // A mapped pack file. Views into it stay valid until Close.
+    struct Pack {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        const Header* header = nullptr;
+        const Section* sections = nullptr;
+#ifdef _WIN32
+        void* file = nullptr;
+        void* mapping = nullptr;
+#endif
+    };
+
+    // Points into the mapped scene section; nothing is copied
+    struct Scene_View {
+        uint32_t entity_count = 0;
+        const glm::vec3* positions = nullptr;
+        const glm::vec3* scales = nullptr;
+        const glm::vec3* tints = nullptr;
+        const uint32_t* sprites = nullptr;
+        uint32_t sprite_name_count = 0;
+        const uint32_t* name_offsets = nullptr;
+        const char* names = nullptr;
+
+        const char* sprite_name(uint32_t sprite) const {
+            return names + name_offsets[sprite];
+        }
+    };
+
+    struct Bodies_View {
+        uint32_t entity_count = 0;
+        const float* masses = nullptr;
+    };
+
+    struct Texture_View {
+        int width = 0;
+        int height = 0;
+        const uint8_t* pixels = nullptr;
+    };
+
+    // Maps the file and checks its header, section table and section bounds
+    bool Open(Pack& pack, const std::string& filename);
+    void Close(Pack& pack);
+
+    // Returns nullptr when the pack has no such section
+    const Section* Find_Section(const Pack& pack, Section_Type type, const std::string& name);
+
+    // These return false when the section is missing or malformed
+    bool Get_Scene(const Pack& pack, const std::string& name, Scene_View& scene);
+    bool Get_Bodies(const Pack& pack, const std::string& name, Bodies_View& bodies);
+    bool Get_Shader_Source(const Pack& pack, const std::string& name, std::string& source);
+    bool Get_Texture(const Pack& pack, const std::string& name, Texture_View& texture);
+
+    // Collects sections in memory and writes them as one pack
+    struct Pack_Writer {
+        std::vector<Section> sections;
+        // Section data, each section starting at a multiple of SECTION_ALIGNMENT
+        std::vector<uint8_t> data;
+
+        // Returns a pointer to `size` zeroed bytes for the section to fill in
+        uint8_t* add_section(Section_Type type, const std::string& name, size_t size);
+    };
+
+    // `sprites` may be null when no entity has a sprite
+    void Add_Scene(Pack_Writer& writer, const std::string& name, uint32_t entity_count,
+                   const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints,
+                   const uint32_t* sprites, const std::vector<std::string>& sprite_names);
+    void Add_Bodies(Pack_Writer& writer, const std::string& name, uint32_t entity_count, const float* masses);
+    void Add_Shader(Pack_Writer& writer, const std::string& name, const std::string& source);
+    void Add_Texture(Pack_Writer& writer, const std::string& name, int width, int height, const uint8_t* pixels);
+
+    bool Write_Pack(const Pack_Writer& writer, const std::string& filename);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef ENTITY_STORE_HPP
+#define ENTITY_STORE_HPP
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Asset_Pack.hpp"
+#include "Renderer.hpp"
+#include "Spatial_Grid.hpp"
+
+// Stable reference to an entity. The generation is bumped whenever a slot is
+// reused so stale handles can be detected.
+struct Entity_Handle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+// Structure-of-arrays storage for sprite entities. Components of live entities
+// are packed densely so systems can iterate them linearly; removal swaps the
+// last entity into the hole. The bounds of every entity are indexed by slot in
+// a spatial grid, so positions, scales and tints only change through
+// set_transform, set_tint and move_parallel, which also record the entity as
+// changed.
+class Entity_Store {
+public:
+    Spatial_Grid grid;
+    // Dense indices of the entities found by the last cull, in ascending order
+    std::vector<uint32_t> visible;
+
+    Entity_Handle create(glm::vec3 position, glm::vec3 scale, glm::vec3 tint);
+    void destroy(Entity_Handle handle);
+    void set_transform(Entity_Handle handle, glm::vec3 position, glm::vec3 scale);
+    void set_tint(Entity_Handle handle, glm::vec3 tint);
+    // Bulk form of set_transform for systems moving every entity each frame.
+    // `move` runs on the job system with a range of dense indices and writes
+    // their positions in place. Only entities whose position changed are
+    // marked changed, and their grid bounds are updated on the same job
+    // unless they cross into another cell, which the calling thread handles
+    // once every range is done.
+    void move_parallel(int grain, const std::function<void(int first, int count, glm::vec3* positions)>& move);
+
+    bool is_alive(Entity_Handle handle) const;
+    uint32_t index_of(Entity_Handle handle) const;
+    Entity_Handle handle_of(uint32_t index) const;
+    int size() const { return (int) positions.size(); }
+    // Components by dense index
+    const glm::vec3& position(uint32_t index) const { return positions[index]; }
+    const glm::vec3& scale(uint32_t index) const { return scales[index]; }
+    const glm::vec3& tint(uint32_t index) const { return tints[index]; }
+
+    void build_vertices(float* stream, int first, int count) const;
+    void build_batch(Renderer::Sprite_Batch& batch) const;
+    // Splits the build into per-thread slices of `stream` on the job system.
+    // The pointer forms write size() quads, or visible.size() for
+    // build_visible_parallel, into memory such as a mapped ring segment.
+    void build_vertices_parallel(std::vector<float>& stream) const;
+    void build_vertices_parallel(float* stream) const;
+    // Same split for the per-instance attributes of every entity
+    void build_instances_parallel(std::vector<Renderer::Instance>& instances) const;
+
+    // Fills `visible` with the entities overlapping the view rectangle
+    void cull(glm::vec2 view_min, glm::vec2 view_max);
+    // Builds vertices for the culled entities only, see build_vertices_parallel
+    void build_visible_parallel(std::vector<float>& stream) const;
+    void build_visible_parallel(float* stream) const;
+
+    // True when an entity was created, destroyed or changed since the last
+    // build_changes or clear_changes
+    bool has_changes() const { return !changed_indices.empty() || removed; }
+    // Rewrites the vertices of changed entities in the batch and marks them
+    // dirty, so only those are uploaded
+    void build_changes(Renderer::Resident_Batch& batch);
+    void clear_changes();
+
+    // Creates an entity for every entity of a pack scene
+    void load(const Asset_Pack::Scene_View& scene);
+    // Adds the live entities as a pack scene
+    void save(Asset_Pack::Pack_Writer& writer, const std::string& name) const;
+
+    // Topmost entity whose quad contains `point`, or an invalid handle if
+    // there is none. Nothing is depth tested, so the topmost is the one drawn
+    // last: the highest dense index.
+    Entity_Handle pick(glm::vec2 point) const;
+    // Appends every entity whose quad overlaps the box
+    void select(glm::vec2 box_min, glm::vec2 box_max, std::vector<Entity_Handle>& selection) const;
+
+private:
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::vec3> tints;
+
+    std::vector<uint32_t> slot_to_index;
+    std::vector<uint32_t> slot_generation;
+    std::vector<uint32_t> index_to_slot;
+    std::vector<uint32_t> free_slots;
+    // Change tracking by dense index; the flags keep the list free of repeats
+    std::vector<uint8_t> changed;
+    std::vector<uint32_t> changed_indices;
+    bool removed = false;
+    void mark_changed(uint32_t index);
+    // Scratch for grid queries
+    mutable std::vector<uint32_t> query_slots;
+    // Gathered by move_parallel from its jobs
+    std::vector<uint32_t> moved_indices;
+    std::vector<uint32_t> crossing_indices;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef EXTENSIONS_HPP
+#define EXTENSIONS_HPP
+
+#include "glad/glad.h"
+
+// The glad loader is generated for core 4.3 without extensions. Entry points
+// and enums from newer versions or extensions the renderer can use are loaded
+// here when the driver provides them.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+namespace Renderer {
+    struct Extensions {
+        bool buffer_storage = false;
+        bool parallel_shader_compile = false;
+    };
+
+    extern Extensions extensions;
+
+    extern PFNGLBUFFERSTORAGEPROC gl_buffer_storage;
+    extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC gl_max_shader_compiler_threads;
+
+    bool Has_Extension(const char* name);
+
+    // Must be called after gladLoadGLLoader with the same loader
+    void Load_Extensions(GLADloadproc load);
+};
+
+#endif
\ No newline at end of file
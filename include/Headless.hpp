@@ -0,0 +1,39 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include <string>
+
+// Offscreen benchmark mode. Renders a synthetic scene into a framebuffer
+// object for a fixed number of frames and writes CPU and GPU frame time
+// statistics to JSON. On Linux the context is EGL surfaceless, so it runs on
+// GPU-less machines with Mesa llvmpipe; elsewhere an invisible GLFW window is
+// used.
+namespace Headless {
+    struct Options {
+        int frames = 1000;
+        int entities = 10000;
+        // Share of the entities that never move, drawn from a resident buffer
+        float static_fraction = 0.0f;
+        // Glyphs of wrapped text drawn over the scene every frame
+        int text = 0;
+        // Tiles per side of a map scrolled under the scene, with one tile in
+        // view edited every frame
+        int tilemap = 0;
+        // Draws the moving entities from one shared quad with per-instance
+        // attributes, instead of streaming four transformed vertices each
+        bool instanced = false;
+        int width = 800;
+        int height = 600;
+        std::string output = "benchmark.json";
+        // Chrome trace of the run, written when set
+        std::string trace;
+    };
+
+    // Returns true when --headless was passed. Also reads --frames, --entities,
+    // --static, --text, --tilemap, --instanced, --output and --trace.
+    bool Parse_Arguments(int argc, char** argv, Options& options);
+
+    int Run(Options& options);
+};
+
+#endif
\ No newline at end of file
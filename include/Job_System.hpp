@@ -0,0 +1,35 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <functional>
+
+// Work-stealing thread pool. Every worker owns a deque: it pushes and pops its
+// own jobs at the back while idle workers steal from the front of the others.
+// Threads that wait on a counter run jobs instead of blocking, so the main
+// thread helps out while it waits. GL calls must stay on the main thread.
+namespace Jobs {
+    // Counts the unfinished jobs of a group
+    struct Counter {
+        std::atomic<int> pending { 0 };
+    };
+
+    // Starts `worker_count` threads, or one less than the core count if
+    // negative. With 0 every job runs inline on the thread that queues it.
+    void Initialize(int worker_count = -1);
+    void Shutdown();
+
+    // Workers plus the calling thread
+    int Thread_Count();
+
+    void Run(Counter& counter, std::function<void()> job);
+
+    // Runs queued jobs until every job of the counter has finished
+    void Wait(Counter& counter);
+
+    // Splits [0, count) into slices of at least `grain` items, one job each,
+    // and waits for all of them. Calls job(first, count) per slice.
+    void Parallel_For(int count, int grain, const std::function<void(int, int)>& job);
+};
+
+#endif
\ No newline at end of file
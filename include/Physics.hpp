@@ -0,0 +1,154 @@
+#ifndef PHYSICS_HPP
+#define PHYSICS_HPP
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Asset_Pack.hpp"
+#include "Entity_Store.hpp"
+#include "Renderer.hpp"
+
+// Non-rotating 2D rigid bodies with box or convex polygon shapes. A step
+// integrates velocities, finds overlapping bounds with sort-and-sweep along x,
+// resolves the overlaps with separating axis tests, and solves the contacts
+// with sequential impulses. Bodies never rotate, so boxes stay axis aligned
+// and a contact needs only a normal and a depth.
+namespace Physics {
+    constexpr int MAX_POLYGON_VERTICES = 8;
+    // Sentinels after the sweep arrays, enough for one 4-wide read past the end
+    constexpr int SWEEP_PADDING = 4;
+
+    // Convex, counter-clockwise, relative to the body position
+    struct Polygon {
+        int vertex_count = 0;
+        glm::vec2 vertices[MAX_POLYGON_VERTICES];
+    };
+
+    struct Contact {
+        // Sweep positions of the two bodies, see World::sweep_ids
+        uint32_t a;
+        uint32_t b;
+        // Points from a to b
+        glm::vec2 normal;
+        float depth;
+        // 1 / (inverse mass of a + inverse mass of b)
+        float mass;
+        // Separating velocity the solver aims for, from restitution
+        float target_velocity;
+        // Separating speed that removes part of the overlap this step. It only
+        // moves the bodies and is forgotten afterwards, so it adds no energy.
+        float separation_velocity;
+        // Accumulated over the solver iterations; the first two are kept for
+        // warm starting
+        float normal_impulse;
+        float tangent_impulse;
+        float separation_impulse;
+    };
+
+    // Impulses of a contact from the previous step, stored with one body of
+    // the pair and keyed by the other
+    struct Cached_Impulse {
+        uint32_t other;
+        float normal_impulse;
+        float tangent_impulse;
+    };
+
+    class World {
+    public:
+        glm::vec2 gravity = { 0.0f, -600.0f };
+        int iterations = 8;
+        float restitution = 0.0f;
+        float friction = 0.4f;
+        // Penetration left alone, and the share of the rest corrected per step
+        float slop = 0.05f;
+        float correction = 0.2f;
+        // Cleared by benchmarks to time the scalar overlap tests
+        bool use_simd = true;
+
+        // Bodies, indexed by the id returned from create_box and create_polygon
+        std::vector<glm::vec2> positions;
+        std::vector<glm::vec2> velocities;
+        // Zero for static bodies
+        std::vector<float> inverse_masses;
+        // Bounds relative to the position
+        std::vector<glm::vec2> local_min;
+        std::vector<glm::vec2> local_max;
+        // Index into `polygons`, or -1 for boxes
+        std::vector<int32_t> shapes;
+        std::vector<Polygon> polygons;
+
+        // Bodies sorted by the left edge of their bounds, with the bounds copied
+        // in that order so the sweep reads them linearly. The arrays end in
+        // SWEEP_PADDING sentinels so overlap tests may read past the last body.
+        std::vector<uint32_t> sweep_ids;
+        std::vector<float> sweep_min_x;
+        std::vector<float> sweep_max_x;
+        std::vector<float> sweep_min_y;
+        std::vector<float> sweep_max_y;
+
+        // Sweep positions of bodies whose bounds overlap, from find_pairs
+        std::vector<uint32_t> pairs;
+        std::vector<Contact> contacts;
+
+        // A mass of zero makes the body static
+        uint32_t create_box(glm::vec2 position, glm::vec2 half_extent, float mass);
+        // At most MAX_POLYGON_VERTICES vertices, relative to the position
+        uint32_t create_polygon(glm::vec2 position, const glm::vec2* vertices, int vertex_count, float mass);
+        int size() const { return (int) positions.size(); }
+
+        void step(float dt);
+
+        // Sorts the bodies along x and fills `pairs`. Pairs of two static
+        // bodies are skipped.
+        void find_pairs();
+
+        // Writes every shape as SPRITE_FORMAT quads, filled in normal drawing
+        // and outlined when polygons are drawn as lines
+        void build_debug_shapes(Renderer::Sprite_Batch& batch) const;
+
+    private:
+        // Velocities and inverse masses in sweep order for the solver, so the
+        // contacts of neighbouring bodies touch neighbouring memory
+        std::vector<glm::vec2> solver_velocities;
+        // Velocities from overlap correction alone, see Contact
+        std::vector<glm::vec2> solver_separations;
+        std::vector<float> solver_inverse_masses;
+        // Impulses of the last step grouped by one body of each pair; the
+        // group of body i is [cache_offsets[i], cache_offsets[i + 1])
+        std::vector<uint32_t> cache_offsets;
+        std::vector<uint32_t> cache_cursors;
+        std::vector<Cached_Impulse> cache;
+        // Set when bodies were added since the last sort
+        bool resort = true;
+
+        void sort_bounds();
+        void find_contacts(float dt);
+        void warm_start();
+        void solve_contacts();
+        void store_impulses();
+    };
+};
+
+// An entity moved by a physics body
+struct Solid {
+    Entity_Handle entity;
+    uint32_t body;
+};
+
+// Copies the body positions of the solids into their entities
+void Sync_Solids(const Physics::World& world, Entity_Store& entities, const std::vector<Solid>& solids);
+
+// Adds the bodies of the solids as a bodies section, for the scene saved by
+// Entity_Store::save under the same name. Only the mass is kept: every body
+// is loaded again as a box the size of its entity's quad, at rest.
+void Save_Solids(Asset_Pack::Pack_Writer& writer, const std::string& name, const Physics::World& world,
+                 const Entity_Store& entities, const std::vector<Solid>& solids);
+// Creates the bodies of a bodies section for the entities of its scene, loaded
+// from dense index `first` on
+void Load_Solids(const Asset_Pack::Bodies_View& bodies, uint32_t first, Physics::World& world,
+                 const Entity_Store& entities, std::vector<Solid>& solids);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+
+#include "Renderer.hpp"
+#include "Render_Queue.hpp"
+
+// Frame profiler. CPU zones are timed on the thread that runs them and written
+// to a per-thread ring without locks; GPU zones use GL_TIMESTAMP queries that
+// are read two frames later, and skipped rather than waited on when the
+// results are not ready. Write_Trace saves the recorded events as Chrome trace
+// JSON, which also opens in Perfetto.
+//
+// The zone macros compile to nothing unless PROFILER_ENABLED is defined
+// (make PROFILE=1). Frame times and the frame graph work either way.
+#ifdef PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) Profiler::Gpu_Zone PROFILE_CONCAT(profile_gpu_zone_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::Set_Thread_Name(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_GPU_ZONE(name)
+#define PROFILE_THREAD(name)
+#endif
+
+namespace Profiler {
+    // Events kept per thread; older events are overwritten
+    constexpr int EVENT_CAPACITY = 1 << 16;
+    constexpr int MAX_THREADS = 64;
+    // GPU zones per frame; more are not timed
+    constexpr int MAX_GPU_ZONES = 32;
+    // Frames shown by the frame graph
+    constexpr int GRAPH_FRAMES = 240;
+
+    // Times the enclosing scope. `name` must outlive the profiler, so use
+    // string literals.
+    struct Zone {
+        const char* name;
+        uint64_t start_ns;
+
+        Zone(const char* name);
+        ~Zone();
+    };
+
+    // Times the GL commands issued in the enclosing scope. Main thread only.
+    struct Gpu_Zone {
+        int index;
+
+        Gpu_Zone(const char* name);
+        ~Gpu_Zone();
+    };
+
+    struct Frame_Times {
+        // Milliseconds of the last GRAPH_FRAMES frames, oldest first from `next`
+        float cpu_ms[GRAPH_FRAMES] = {};
+        float gpu_ms[GRAPH_FRAMES] = {};
+        int next = 0;
+        // GPU frames whose queries were not ready in time
+        int gpu_dropped = 0;
+    };
+
+    extern Frame_Times frame_times;
+
+    // Creates the timestamp queries and the frame graph batch. Needs the GL
+    // context; `shader` is the color shader the graph is drawn with.
+    void Initialize(Renderer::Shader_Handle shader);
+
+    // Names the calling thread in the trace
+    void Set_Thread_Name(const char* name);
+
+    uint64_t Now_Ns();
+    void Record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+    // Collects the GPU zones issued two frames ago and starts timing a frame
+    void Begin_Frame();
+    void End_Frame();
+
+    // Queues the frame graph at the bottom left of the screen, drawn over
+    // everything else. Bars are CPU frame times against a 16.7 ms line, with
+    // GPU frame times as thin blue bars.
+    void Submit_Graph(Renderer::Render_Queue& queue);
+
+    // Writes the events still held by every thread. Events written while the
+    // trace is saved may be left out.
+    bool Write_Trace(const std::string& path);
+};
+
+#endif
\ No newline at end of file
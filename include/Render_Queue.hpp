@@ -0,0 +1,65 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "Renderer.hpp"
+
+namespace Renderer {
+    struct Draw_Command {
+        uint64_t key;
+        Shader_Handle shader;
+        VAO_Handle vao;
+        GLuint texture;
+        GLenum primitive;
+        // Drawn through the shared quad indices, see Draw_Vertices
+        bool indexed;
+        int first;
+        int count;
+        int instance_count;
+        // Ring segment the draw reads, fenced once the draw is issued. A
+        // batch may be written again before the queue is flushed, so the
+        // ring's current segment can be a later one.
+        Stream_Ring* ring;
+        int segment;
+    };
+
+    // Deferred draws for one frame. Commands are radix sorted by a key of
+    // (layer, shader, texture, VAO) and issued with only the binds that change
+    // between neighbours. The layer is the most significant part so painter's
+    // order between layers is kept; the sort is stable, so commands with equal
+    // keys draw in submission order.
+    struct Render_Queue {
+        std::vector<Draw_Command> commands;
+        std::vector<Draw_Command> sorted;
+
+        // Drops the commands without drawing them
+        void clear();
+    };
+
+    void Submit(Render_Queue& queue, Shader_Handle shader, VAO_Handle vao, Vertex_Buffer& buffer, uint16_t layer, GLuint texture = 0);
+
+    // Queues vertices [first, first + count) of a buffer object that is
+    // already uploaded, such as one slot of a pool
+    void Submit_Vertices(Render_Queue& queue, Shader_Handle shader, VAO_Handle vao, const Vertex_Buffer& buffer, int first, int count, uint16_t layer, GLuint texture = 0);
+
+    // Uploads the batch now, unless it is marked unchanged, and queues its draw
+    void Submit_Batch(Render_Queue& queue, Shader_Handle shader, Sprite_Batch& batch, uint16_t layer, GLuint texture = 0);
+
+    // Uploads only the dirty ranges of the batch and queues its draw
+    void Submit_Resident(Render_Queue& queue, Shader_Handle shader, Resident_Batch& batch, uint16_t layer, GLuint texture = 0);
+
+    void Submit_Instanced(Render_Queue& queue, Shader_Handle shader, Instance_Batch& batch, uint16_t layer, GLuint texture = 0);
+
+    // Fills queue.sorted with the commands in draw order, using
+    // queue.commands as scratch. Touches no GL state; Flush_Queue sorts
+    // this way before drawing.
+    void Sort_Queue(Render_Queue& queue);
+
+    void Flush_Queue(Render_Queue& queue);
+};
+
+#endif
\ No newline at end of file
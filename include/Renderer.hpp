@@ -3,22 +3,246 @@
 
 #include "glad/glad.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
 #include "Utils.hpp"
+#include "Extensions.hpp"
+
+namespace Asset_Pack {
+    struct Pack;
+}
 
 namespace Renderer {
-    extern std::map<std::string, GLuint> shader_map;
-    extern std::map<std::string, GLuint> vao_map;
+    // Dense indices into the renderer's object tables. Names are resolved to a
+    // handle once at creation, so per-frame calls index a flat array and never
+    // build, hash or compare strings.
+    struct Shader_Handle {
+        uint32_t id = UINT32_MAX;
+    };
+
+    struct VAO_Handle {
+        uint32_t id = UINT32_MAX;
+    };
+
+    // Time spent blocked on shader creation, including reading sources,
+    // loading cached binaries and waiting for compiles on first use
+    struct Shader_Stats {
+        int compiled = 0;
+        int cache_hits = 0;
+        double startup_ms = 0.0;
+    };
+
+    // Linked program binaries are cached here, keyed by source and driver
+    constexpr const char* SHADER_CACHE_DIRECTORY = "cache/shaders";
+
+    struct Frame_Stats {
+        int draw_calls = 0;
+        size_t bytes_uploaded = 0;
+        int fence_waits = 0;
+        int commands = 0;
+        int program_switches = 0;
+        int vao_binds = 0;
+        int texture_binds = 0;
+        // Separate writes into buffer objects
+        int buffer_updates = 0;
+    };
+
+    // Triple-buffered storage for vertex data rewritten every frame. Each update
+    // writes the next segment while the GPU may still read the previous ones,
+    // and a fence per segment guards its reuse. The storage is mapped
+    // persistently when buffer storage is available, otherwise each segment is
+    // mapped unsynchronized on write.
+    struct Stream_Ring {
+        static constexpr int SEGMENT_COUNT = 3;
+
+        GLuint vao = 0;
+        GLuint shader = 0;
+        size_t segment_size = 0;
+        int segment = 0;
+        GLsync fences[SEGMENT_COUNT] = {};
+        char* mapped = nullptr;
+        bool persistent = false;
+        int first_vertex = 0;
+        int vertex_count = 0;
+        // Draws of the ring waiting in a Render_Queue. Growing the ring
+        // replaces its buffer object under them, so it must not happen while
+        // any are queued: submit a batch at most once between flushes.
+        int queued_draws = 0;
+    };
+
+    // Collects the transformed vertices of many sprites into one buffer so they
+    // can be sent with a single draw call. The vertices stream through a ring
+    // sized for `capacity` sprites that only grows when a frame needs more.
+    struct Sprite_Batch {
+        VAO_Handle vao;
+        Vertex_Buffer buffer;
+        Stream_Ring ring;
+        int sprite_count = 0;
+        // Set by the caller when the stream matches the last upload, so the
+        // segment written then is drawn again without uploading
+        bool unchanged = false;
+        // Ring segment handed out by Map_Batch, or -1
+        int write_segment = -1;
+
+        void clear();
+        void add(Sprite& sprite);
+    };
+
+    // Sprites [first, first + count) of a batch
+    struct Sprite_Range {
+        int first;
+        int count;
+    };
+
+    // Sprite vertices kept in GPU memory across frames. Only ranges marked
+    // dirty are rewritten, merged into as few glBufferSubData calls as
+    // possible, so a batch whose sprites did not change uploads nothing.
+    // Static scenery uses GL_STATIC_DRAW and is uploaded once.
+    struct Resident_Batch {
+        VAO_Handle vao;
+        // CPU copy of every vertex in the buffer object
+        Vertex_Buffer buffer;
+        GLenum usage = GL_DYNAMIC_DRAW;
+        int sprite_count = 0;
+        int capacity = 0;
+        std::vector<Sprite_Range> dirty;
+
+        void mark_dirty(int first, int count);
+    };
+
+    // Dirty ranges closer than this many sprites are uploaded as one, trading a
+    // few redundant bytes for fewer calls. The gap is widened while more than
+    // MAX_UPLOAD_RANGES remain, since every call has a fixed driver cost.
+    constexpr int RANGE_MERGE_GAP = 16;
+    constexpr int MAX_UPLOAD_RANGES = 256;
+
+    // Per-instance attributes of a sprite drawn through the instanced path
+    struct Instance {
+        glm::vec3 position;
+        glm::vec3 scale;
+        glm::vec3 tint;
+        // Atlas region as (min u, min v, max u, max v)
+        glm::vec4 uv_rect;
+    };
+
+    // Draws every sprite from one shared unit quad. Only the position, scale,
+    // tint and atlas region of each sprite are uploaded; the quad is
+    // transformed in the shader. Sprites from one atlas draw in a single call.
+    struct Instance_Batch {
+        VAO_Handle vao;
+        GLuint mesh_buffer_object;
+        GLuint instance_buffer_object;
+        int vertex_count = 0;
+        int capacity = 0;
+        std::vector<Instance> instances;
+
+        void clear();
+        void add(Transform& transform, Sprite& sprite);
+    };
+
+    extern std::vector<GLuint> shaders;
+    // Nonzero while a shader's compile and link status has not been checked
+    extern std::vector<uint8_t> shader_pending;
+    extern std::vector<GLuint> vaos;
+    // Name lookups for setup code only
+    extern std::map<std::string, Shader_Handle> shader_map;
+    extern std::map<std::string, VAO_Handle> vao_map;
+    extern Frame_Stats frame_stats;
+    extern Shader_Stats shader_stats;
+
+    void Resolve_Shader(Shader_Handle shader);
+
+    // The first use of a shader waits for its compile and checks the result
+    inline GLuint Get_Shader(Shader_Handle shader) {
+        if (shader_pending[shader.id])
+            Resolve_Shader(shader);
+        return shaders[shader.id];
+    }
+    inline GLuint Get_VAO(VAO_Handle vao) { return vaos[vao.id]; }
+
+    Shader_Handle Find_Shader(const std::string& name);
+    VAO_Handle Find_VAO(const std::string& name);
+
+    // Shader sources are taken from this pack when it holds them, otherwise
+    // from the assets directory. Pass nullptr to unmount.
+    void Mount_Pack(const Asset_Pack::Pack* pack);
+
+    Shader_Handle Create_Shader(std::string filename);
+
+    // Loads the program from the binary cache, or queues its compile and link
+    // without waiting for them
+    Shader_Handle Create_Shader(std::string name, std::string vertex_file, std::string fragment_file);
+
+    // True once the driver has finished compiling, without blocking
+    bool Shader_Ready(Shader_Handle shader);
+
+    // Resolves every pending shader
+    void Wait_Shaders();
+
+    // Sets up the attributes described by buffer_format.format. Indexed
+    // buffers also get the shared quad index buffer.
+    VAO_Handle Initialize_VAO(std::string vao_name, Shader_Handle shader, Vertex_Buffer& buffer_format);
+
+    // Grows the shared quad index buffer to cover `quad_count` quads. It is
+    // refilled in place, so VAOs already bound to it stay valid.
+    void Reserve_Quad_Indices(int quad_count);
+
+    // Draws from the bound VAO. Indexed buffers go through the shared quad
+    // indices with `first_vertex` as the base vertex.
+    void Draw_Vertices(GLenum primitive, bool indexed, int first_vertex, int vertex_count);
+
+    void Update_VAO_Buffer(VAO_Handle vao, Vertex_Buffer& buffer);
+
+    VAO_Handle Initialize_Stream(std::string vao_name, Shader_Handle shader, Vertex_Buffer& buffer, Stream_Ring& ring, size_t segment_size);
+
+    // Returns the next ring segment for writing `float_count` floats in place
+    float* Map_Stream(Vertex_Buffer& buffer, size_t float_count);
+
+    void Unmap_Stream(Vertex_Buffer& buffer);
+
+    // Marks a segment as in use by the draws issued so far
+    void Fence_Stream(Stream_Ring& ring, int segment);
+
+    void Draw(VAO_Handle vao, Vertex_Buffer& buffer);
+
+    void Begin_Frame();
+
+    // Quads of another layout, such as text in TEXTURED_SPRITE_FORMAT, can be
+    // batched by passing its format
+    void Initialize_Batch(std::string vao_name, Shader_Handle shader, Sprite_Batch& batch, int capacity, const Vertex_Format& format = SPRITE_FORMAT);
+
+    void Draw_Batch(Sprite_Batch& batch);
+
+    // Sprites can be built straight into the ring instead of buffer.stream.
+    // Map_Batch returns the segment after the one drawn now, with room for
+    // `capacity` sprites, and may be written from any thread while the
+    // current segment is drawn. Commit_Batch draws the `sprite_count` sprites
+    // written there from then on; a batch never committed keeps drawing the
+    // current segment. Returns nullptr when the ring is not persistently
+    // mapped or the segment is too small; build into buffer.stream then, and
+    // Submit_Batch copies it, growing the ring for the next frames.
+    // Map after submitting the batch for this frame, which may take the next
+    // segment itself when it copies.
+    float* Map_Batch(Sprite_Batch& batch, int capacity);
+    void Commit_Batch(Sprite_Batch& batch, int sprite_count);
+
+    void Initialize_Resident(std::string vao_name, Shader_Handle shader, Resident_Batch& batch, int capacity, GLenum usage);
+
+    // Sorts the ranges and merges them into at most MAX_UPLOAD_RANGES, see
+    // RANGE_MERGE_GAP
+    void Coalesce_Ranges(std::vector<Sprite_Range>& ranges);
 
-    void Create_Shader(std::string filename);
+    // Uploads the dirty ranges of the batch and clears them
+    void Upload_Resident(Resident_Batch& batch);
 
-    void Initialize_VAO(std::string vao_handle, GLuint shader, Vertex_Buffer& buffer_format);
+    void Draw_Resident(Resident_Batch& batch);
 
-    void Update_VAO_Buffer(std::string vao_handle, Vertex_Buffer& buffer);
+    void Initialize_Instanced(std::string vao_name, Shader_Handle shader, Instance_Batch& batch, int capacity);
 
-    void Draw(std::string vao_handle, Vertex_Buffer& buffer);
+    // Uploads every instance; Submit_Instanced queues the draw
+    void Upload_Instances(Instance_Batch& batch);
 };
 
 #endif
\ No newline at end of file
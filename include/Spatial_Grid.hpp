@@ -0,0 +1,66 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Loose uniform grid over 2D bounds, keyed by caller ids. Each id lives in the
+// one cell holding the center of its bounds, and queries widen their area by
+// the largest half extent seen so far to catch bounds that hang over a cell
+// edge. Bounds wider than a cell would widen every query, so they are kept in
+// a separate list that queries test one by one instead; the widening is thus
+// never more than half a cell. Cells are hashed, so the world has no fixed
+// size and empty space costs nothing.
+class Spatial_Grid {
+public:
+    explicit Spatial_Grid(float cell_size = 128.0f);
+
+    void insert(uint32_t id, glm::vec2 min, glm::vec2 max);
+    // Only touches the cell lists when the center crosses into another cell,
+    // or the bounds grow past or shrink within a cell
+    void move(uint32_t id, glm::vec2 min, glm::vec2 max);
+    // Updates the bounds when that needs no change to the cell lists or the
+    // query widening, and returns whether it did; ids it refuses must be
+    // moved with move. Calls for distinct ids may run in parallel, as long as
+    // nothing else changes the grid meanwhile.
+    bool move_in_place(uint32_t id, glm::vec2 min, glm::vec2 max);
+    void remove(uint32_t id);
+    bool contains(uint32_t id) const;
+
+    // Appends the ids whose bounds overlap [min, max]
+    void query(glm::vec2 min, glm::vec2 max, std::vector<uint32_t>& out) const;
+
+    void clear();
+
+private:
+    struct Entry {
+        bool present = false;
+        // In `oversized` rather than a cell
+        bool oversized = false;
+        uint64_t cell = 0;
+        // Position in the cell's or oversized id list, for constant time removal
+        uint32_t position = 0;
+        glm::vec2 min;
+        glm::vec2 max;
+    };
+
+    float cell_size;
+    float inverse_cell_size;
+    // Of the ids in cells only, so at most half a cell
+    glm::vec2 max_half_extent = glm::vec2(0.0f);
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<uint32_t> oversized;
+    std::vector<Entry> entries;
+
+    glm::ivec2 cell_coordinates(glm::vec2 point) const;
+    bool is_oversized(glm::vec2 min, glm::vec2 max) const;
+    uint64_t cell_of(glm::vec2 min, glm::vec2 max) const;
+    void add_to_list(uint32_t id);
+    void remove_from_list(uint32_t id);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef TEXT_HPP
+#define TEXT_HPP
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderer.hpp"
+#include "Render_Queue.hpp"
+
+namespace Renderer {
+    // Printable ASCII; other characters draw as '?'
+    constexpr int FIRST_GLYPH = 32;
+    constexpr int GLYPH_COUNT = 95;
+    // Above the scene, below the profiler graph
+    constexpr uint16_t TEXT_LAYER = UINT16_MAX - 1;
+
+    // Signed distance fields of the built-in 8x8 font, rasterized once into a
+    // single-channel texture. A texel holds 0.5 on the glyph edge, rising
+    // inside, and reaches 0 or 1 `spread` texels away, so glyphs stay sharp at
+    // any size through the text shader's smoothstep.
+    struct Glyph_Atlas {
+        GLuint texture = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> distances;
+        // Texels per glyph cell, including the spread on every side
+        int cell_size = 0;
+        // Part of a cell covered by the 8x8 glyph box
+        float glyph_share = 0.0f;
+        // (min u, min v, max u, max v) of every cell, packed as 16-bit
+        // normalized texture coordinates
+        uint16_t cells[GLYPH_COUNT][4];
+    };
+
+    // `glyph_size` texels per glyph box side, plus `spread` on every side
+    void Build_Glyph_Atlas(Glyph_Atlas& atlas, int glyph_size = 32, int spread = 4);
+    // Creates or replaces the GL texture from atlas.distances
+    void Upload_Glyph_Atlas(Glyph_Atlas& atlas);
+
+    // One glyph quad, relative to the top left of the text
+    struct Glyph_Quad {
+        glm::vec2 min;
+        glm::vec2 max;
+        int glyph;
+    };
+
+    // Line breaks on '\n', and on spaces before words that would cross
+    // max_width when it is above 0. The font is monospaced, so every glyph
+    // advances by `size`.
+    struct Text_Layout {
+        std::vector<Glyph_Quad> quads;
+        glm::vec2 size = { 0.0f, 0.0f };
+    };
+
+    void Layout_Text(const std::string& text, float size, float max_width, Text_Layout& layout);
+
+    // Layouts of recently drawn strings. Entries not used for `max_age`
+    // frames are dropped by end_frame.
+    struct Text_Cache {
+        struct Entry {
+            std::string text;
+            // Never matches a real size, so new entries are always laid out
+            float size = -1.0f;
+            float max_width = 0.0f;
+            Text_Layout layout;
+            int last_used = 0;
+        };
+
+        std::unordered_map<uint64_t, Entry> entries;
+        int frame = 0;
+        int max_age = 120;
+        int hits = 0;
+        int misses = 0;
+
+        // Lays the text out only when no cached layout matches
+        const Text_Layout& get(const std::string& text, float size, float max_width);
+        void end_frame();
+    };
+
+    // A string drawn in screen space. `position` is the top left corner.
+    struct Text {
+        std::string string;
+        glm::vec2 position = { 0.0f, 0.0f };
+        float size = 16.0f;
+        glm::vec3 color = { 1.0f, 1.0f, 1.0f };
+        float max_width = 0.0f;
+    };
+
+    // Appends the glyph quads of the text to a batch created with
+    // TEXTURED_SPRITE_FORMAT, so any number of strings go out in one draw
+    // through the text shader with the glyph atlas bound.
+    void Add_Text(Sprite_Batch& batch, Text_Cache& cache, const Glyph_Atlas& atlas, const Text& text);
+    void Add_Layout(Sprite_Batch& batch, const Glyph_Atlas& atlas, const Text_Layout& layout, glm::vec2 position, glm::vec3 color);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef TEXTURE_ATLAS_HPP
+#define TEXTURE_ATLAS_HPP
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Asset_Pack.hpp"
+#include "Utils.hpp"
+
+namespace Renderer {
+    // 8-bit RGBA pixels, first row at the bottom like GL textures
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Reads uncompressed or run-length encoded 24/32-bit TGA files
+    bool Load_TGA(const std::string& filename, Image& image);
+    bool Save_TGA(const std::string& filename, const Image& image);
+
+    // Bottom-left skyline packer. The skyline is the top edge of the packed
+    // rectangles as a list of horizontal segments; each rectangle is placed on
+    // the segment run that leaves it lowest, ties broken by the narrowest fit.
+    struct Skyline_Packer {
+        struct Segment {
+            int x;
+            int y;
+            int width;
+        };
+
+        int width = 0;
+        int height = 0;
+        std::vector<Segment> skyline;
+
+        void reset(int atlas_width, int atlas_height);
+        // Returns false when the rectangle does not fit
+        bool insert(int rect_width, int rect_height, int& x, int& y);
+    };
+
+    // Many images packed into one texture so sprites using any of them draw
+    // with a single texture bind. Regions are looked up by name at load time
+    // and stored in Sprite::uv_rect.
+    struct Texture_Atlas {
+        GLuint texture = 0;
+        Image image;
+        std::map<std::string, UV_Rect> regions;
+        // Pixels covered by images (without padding) over the atlas area
+        float efficiency = 0.0f;
+    };
+
+    // Packs `images` into an atlas of power-of-two width, no larger than
+    // max_size on either side, and fills atlas.image and atlas.regions. Every
+    // image is surrounded by `padding` pixels copied from its edge so
+    // filtering does not bleed between neighbours.
+    bool Build_Atlas(Texture_Atlas& atlas, const std::vector<std::string>& names, const std::vector<Image>& images, int max_size = 4096, int padding = 1);
+
+    // Creates or replaces the GL texture from atlas.image
+    void Upload_Atlas(Texture_Atlas& atlas);
+
+    // Decodes every .tga file in `directory` on the job system, named by file
+    // stem and sorted by name
+    bool Load_Images(const std::string& directory, std::vector<std::string>& names, std::vector<Image>& images);
+
+    // Load_Images, Build_Atlas and Upload_Atlas in one
+    bool Load_Atlas(Texture_Atlas& atlas, const std::string& directory, int max_size = 4096);
+
+    // Load_Atlas from the textures of a pack, which need no decoding
+    bool Load_Atlas(Texture_Atlas& atlas, const Asset_Pack::Pack& pack, int max_size = 4096);
+
+    UV_Rect Find_Region(const Texture_Atlas& atlas, const std::string& name);
+};
+
+#endif
\ No newline at end of file
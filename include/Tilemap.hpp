@@ -0,0 +1,113 @@
+#ifndef TILEMAP_HPP
+#define TILEMAP_HPP
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include "Renderer.hpp"
+#include "Render_Queue.hpp"
+#include "Job_System.hpp"
+
+namespace Renderer {
+    // Tiles per chunk side
+    constexpr int CHUNK_TILES = 32;
+    constexpr int CHUNK_QUADS = CHUNK_TILES * CHUNK_TILES;
+    // Tile id that draws nothing
+    constexpr uint16_t EMPTY_TILE = 0;
+
+    // A square of CHUNK_TILES tiles with its own mesh. The mesh is built on a
+    // worker once the chunk comes into view and stays on the GPU until one of
+    // its tiles is edited or its slot is taken by another chunk.
+    struct Tile_Chunk {
+        // SPRITE_FORMAT quads of every non-empty tile, freed once uploaded
+        std::vector<float> mesh;
+        int quad_count = 0;
+        // Bumped by edits. The mesh is current while built_revision matches,
+        // and the GPU copy while uploaded_revision does.
+        uint32_t revision = 1;
+        uint32_t built_revision = 0;
+        uint32_t uploaded_revision = 0;
+        // Slot of the GPU pool holding the mesh, or -1, and the quads in it
+        int slot = -1;
+        int uploaded_quads = 0;
+        // Frame the chunk was last in view, for slot eviction
+        uint32_t last_visible = 0;
+    };
+
+    // A grid of tiles drawn as chunk meshes from one static buffer object.
+    // Meshes are far too many to keep on the GPU for large maps, so the
+    // buffer is a pool of slots of CHUNK_QUADS quads, handed to chunks in view
+    // and taken back from the ones out of view longest. Every visible chunk
+    // is one draw from the same VAO, so they need no binds in between.
+    struct Tilemap {
+        // In tiles, rounded up to whole chunks
+        int width = 0;
+        int height = 0;
+        int chunks_x = 0;
+        int chunks_y = 0;
+        glm::vec2 origin = { 0.0f, 0.0f };
+        float tile_size = 16.0f;
+
+        // Chunk by chunk, each row by row, so a chunk's tiles are contiguous
+        std::vector<uint16_t> tiles;
+        // Packed RGBA8 color of every tile id; id EMPTY_TILE is never drawn
+        std::vector<uint32_t> palette;
+        std::vector<Tile_Chunk> chunks;
+
+        // Chunks overlapping the view, from Update_Tilemap
+        std::vector<uint32_t> visible;
+        // Chunk meshes built at most per frame, so scrolling onto a new area
+        // spreads its builds over several frames
+        int max_builds_per_frame = 64;
+        Jobs::Counter builds;
+        uint32_t frame = 0;
+
+        VAO_Handle vao;
+        Vertex_Buffer buffer;
+        // Chunk in every slot, or -1
+        std::vector<int32_t> slots;
+        // Chunks copied into their slots by the last Upload_Tilemap
+        std::vector<uint32_t> uploads;
+
+        void resize(int tile_width, int tile_height);
+        uint16_t get(int x, int y) const;
+        // Chunk holding the tile, or -1 outside the map
+        int32_t chunk_of(int x, int y) const;
+        // Marks the tile's chunk for a rebuild when the tile changes. Tiles
+        // must not change between Update_Tilemap and Upload_Tilemap, while
+        // build jobs read them.
+        void set(int x, int y, uint16_t tile);
+    };
+
+    // Writes the quads of every non-empty tile of the chunk into `mesh`.
+    // Reads only the map's tiles and palette, so chunks build in parallel.
+    int Build_Chunk_Mesh(const Tilemap& map, uint32_t chunk, std::vector<float>& mesh);
+
+    // Creates the VAO and a pool of `slot_count` chunk slots. The pool grows
+    // when more chunks are in view at once.
+    void Initialize_Tilemap(std::string vao_name, Shader_Handle shader, Tilemap& map, int slot_count = 64);
+
+    // Finds the chunks overlapping [view_min, view_max] and starts jobs
+    // building the ones whose meshes are missing or stale
+    void Update_Tilemap(Tilemap& map, glm::vec2 view_min, glm::vec2 view_max);
+
+    // The bookkeeping of Upload_Tilemap, without GL. Frees the slots of chunks
+    // edited down to no tiles and gives a slot to every visible chunk whose
+    // mesh is not on the GPU, taken from the chunk out of view longest when
+    // none is free. Chunks losing their slot drop their mesh and are built
+    // again when next in view. Fills `uploads` with the chunks to copy and
+    // returns true when the pool grew, which drops every slot.
+    bool Assign_Tilemap_Slots(Tilemap& map, std::vector<uint32_t>& uploads);
+
+    // Waits for the builds of Update_Tilemap and uploads the new meshes of
+    // chunks in view into their slots
+    void Upload_Tilemap(Tilemap& map);
+
+    // Queues one draw per visible chunk whose mesh is on the GPU
+    void Submit_Tilemap(Render_Queue& queue, Shader_Handle shader, Tilemap& map, uint16_t layer);
+};
+
+#endif
\ No newline at end of file
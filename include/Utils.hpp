@@ -7,25 +7,93 @@
 
 #include <vector>
 
+#include "Vertex_Kernel.hpp"
+
+namespace Renderer {
+    struct Stream_Ring;
+}
+
+// One interleaved vertex attribute, bound to the shader input of the same
+// name. Normalized integer types are read as floats in [0, 1] or [-1, 1].
+struct Vertex_Attribute {
+    const char* name;
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+
+    // Bytes taken in the vertex
+    constexpr int size() const {
+        return components * (type == GL_UNSIGNED_BYTE || type == GL_BYTE ? 1
+                           : type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT ? 2
+                           : 4);
+    }
+};
+
+// Layout of one vertex, attributes packed in order with no padding. The
+// stride must stay a multiple of 4 bytes since streams are built as 32-bit
+// words.
+struct Vertex_Format {
+    static const int MAX_ATTRIBUTES = 4;
+
+    Vertex_Attribute attributes[MAX_ATTRIBUTES];
+    int attribute_count;
+
+    constexpr int stride() const {
+        return attribute_count > 0 ? attributes[attribute_count - 1].size() + offset(attribute_count - 1) : 0;
+    }
+
+    constexpr int offset(int attribute) const {
+        return attribute > 0 ? attributes[attribute - 1].size() + offset(attribute - 1) : 0;
+    }
+};
+
+// 2D position and RGBA8 tint, 12 bytes. What Vertex_Kernel writes.
+constexpr Vertex_Format SPRITE_FORMAT = { {
+    { "in_position", 2, GL_FLOAT, GL_FALSE },
+    { "in_color", 4, GL_UNSIGNED_BYTE, GL_TRUE },
+}, 2 };
+
+// SPRITE_FORMAT with 16-bit normalized atlas coordinates, 16 bytes
+constexpr Vertex_Format TEXTURED_SPRITE_FORMAT = { {
+    { "in_position", 2, GL_FLOAT, GL_FALSE },
+    { "in_color", 4, GL_UNSIGNED_BYTE, GL_TRUE },
+    { "in_texcoord", 2, GL_UNSIGNED_SHORT, GL_TRUE },
+}, 3 };
+
 struct Vertex_Buffer {
     GLuint buffer_object;
     GLenum primitive;
-    
-    int position_size = 0;
-    std::vector<float> position;
-    int color_size = 0;
-    std::vector<float> color;
-    int texcoord_size = 0;
-    std::vector<float> texcoord;
+
+    Vertex_Format format = SPRITE_FORMAT;
+    // Quads of four vertices drawn through the shared quad index buffer,
+    // see Renderer::Reserve_Quad_Indices
+    bool indexed = false;
 
     std::vector<float> stream;
 
-    int get_size() {
-        return position_size + color_size + texcoord_size;
+    // Set when the buffer streams through a ring, see Renderer::Initialize_Stream
+    Renderer::Stream_Ring* ring = nullptr;
+
+    // 32-bit words per vertex
+    int get_size() const {
+        return format.stride() / sizeof(float);
     }
 };
 
+struct Transform {
+    glm::vec3 position;
+    glm::vec3 scale;
+};
+
+// Area of a texture used by a sprite, in normalized texture coordinates
+struct UV_Rect {
+    glm::vec2 min = { 0.0f, 0.0f };
+    glm::vec2 max = { 1.0f, 1.0f };
+};
+
 struct Sprite {
+    // Two triangles, as drawn by the instanced path. Streamed sprites use
+    // Vertex_Kernel::QUAD_CORNERS with shared indices instead.
     std::vector<glm::vec3> mesh = {
         { -0.5f, -0.5f, 0.0f },
         {  0.5f, -0.5f, 0.0f },
@@ -37,61 +105,23 @@ struct Sprite {
     };
 
     glm::vec3 tint = { 1.0f, 1.0f, 1.0f };
-    //std::vector<glm::vec2> texcoord;
+    // Region of the atlas texture, see Renderer::Find_Region
+    UV_Rect uv_rect;
 
     Vertex_Buffer buffer;
-    const int BUFFER_POSITION_SIZE = 3;
-    const int BUFFER_COLOR_SIZE = 3;
-    const int BUFFER_TEXCOORD_SIZE = 0;
 
     Sprite() {
         buffer.primitive = GL_TRIANGLES;
-        
-        buffer.position_size = BUFFER_POSITION_SIZE;
-        buffer.position.resize(mesh.size() * BUFFER_POSITION_SIZE);
-
-        buffer.color_size = BUFFER_COLOR_SIZE;
-        buffer.color.resize(mesh.size() * BUFFER_COLOR_SIZE);
-        
-        buffer.texcoord_size = BUFFER_TEXCOORD_SIZE;
+        buffer.format = SPRITE_FORMAT;
+        buffer.indexed = true;
     }
 
-    void update_buffer(glm::mat4 transform_matrix) {
-        buffer.stream.resize(buffer.position.size() + buffer.color.size() + buffer.texcoord.size());
-
-        for (int v = 0; v < buffer.stream.size() / buffer.get_size(); ++v) {
-            glm::vec3 transformed_position = transform_matrix * glm::vec4(mesh[v], 1.0f);
-
-            buffer.position[BUFFER_POSITION_SIZE * v + 0] = transformed_position.x;
-            buffer.position[BUFFER_POSITION_SIZE * v + 1] = transformed_position.y;
-            buffer.position[BUFFER_POSITION_SIZE * v + 2] = transformed_position.z;
-
-            buffer.color[BUFFER_COLOR_SIZE * v + 0] = tint.x;
-            buffer.color[BUFFER_COLOR_SIZE * v + 1] = tint.y;
-            buffer.color[BUFFER_COLOR_SIZE * v + 2] = tint.z;
+    // Writes the transformed quad straight into the interleaved stream
+    void update_buffer(const glm::vec3& position, const glm::vec3& scale) {
+        buffer.stream.resize(Vertex_Kernel::QUAD_SIZE);
 
-
-            int position_offset = buffer.get_size() * v;
-            for (int p = 0; p < buffer.position_size; ++p) {
-                buffer.stream[position_offset + p] = buffer.position[v * BUFFER_POSITION_SIZE + p];
-            }
-
-            int color_offset = position_offset + BUFFER_COLOR_SIZE;
-            for (int c = 0; c < buffer.color_size; ++c) {
-                buffer.stream[color_offset + c] = buffer.color[v * BUFFER_COLOR_SIZE + c];
-            }
-
-            // int texcoord_offset = color_offset + 0;
-            // for (int t = 0; t < buffer.texcoord.size(); ++t) {
-            //     buffer.stream[texcoord_offset + t] = buffer.texcoord[v * buffer.texcoord_size + t];
-            // }
-        }
+        Vertex_Kernel::Transform_Quads(&position, &scale, &tint, 1, buffer.stream.data());
     }
 };
 
-struct Transform {
-    glm::vec3 position;
-    glm::vec3 scale;
-};
-
 #endif
\ No newline at end of file
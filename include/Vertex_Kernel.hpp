@@ -0,0 +1,40 @@
+#ifndef VERTEX_KERNEL_HPP
+#define VERTEX_KERNEL_HPP
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+
+// Builds sprite vertices in the compact SPRITE_FORMAT layout for many quads:
+// four corners per quad, each a 2D float position followed by the tint packed
+// as normalized RGBA8, drawn as two triangles through the shared quad index
+// buffer. The widest instruction set supported by the CPU is picked at
+// runtime; every path produces the same bits as transforming the corners by
+// translate(position) * scale(scale) with glm.
+namespace Vertex_Kernel {
+    enum class Path { SCALAR, SSE, AVX2 };
+
+    constexpr int QUAD_VERTEX_COUNT = 4;
+    constexpr int QUAD_INDEX_COUNT = 6;
+    // 32-bit words per vertex and per quad
+    constexpr int VERTEX_SIZE = 3;
+    constexpr int QUAD_SIZE = QUAD_VERTEX_COUNT * VERTEX_SIZE;
+
+    extern const glm::vec2 QUAD_CORNERS[QUAD_VERTEX_COUNT];
+    // Two counter-clockwise triangles over QUAD_CORNERS
+    extern const uint32_t QUAD_INDICES[QUAD_INDEX_COUNT];
+
+    // Clamps to [0, 1] and rounds to 8 bits per channel; alpha is opaque
+    uint32_t Pack_Color(const glm::vec3& tint);
+
+    // Writes QUAD_SIZE words per quad to `out`
+    void Transform_Quads(const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints, int count, float* out);
+
+    Path Best_Path();
+    Path Active_Path();
+    // Forces a path, clamped to what the CPU supports. Used by benchmarks.
+    void Set_Path(Path path);
+    const char* Path_Name(Path path);
+};
+
+#endif
\ No newline at end of file
@@ -2,19 +2,6 @@
 
 
 
-// class Text {
-// public:
-//     UI_Transform ui_transform;
-//     std::vector<Font> glyphs;
-// };
-
-// class Solid {
-// public:
-//     std::vector<glm::vec3> vertices;
-//     Body body;
-//     Shape debug_shape;
-// };
-
 // class Sprite {
 // public:
 
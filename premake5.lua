@@ -1,9 +1,14 @@
+newoption {
+   trigger = "profile",
+   description = "Compile in the profiling zones (see include/Profiler.hpp)"
+}
+
 workspace "OpenGL"
    filename "OpenGL_Workspace"
    location("builds/" .. _ACTION)
 
    configurations { "Debug", "Release" }
-   platforms { "Win64" }
+   platforms { "Win64", "Linux64" }
 
 project "OpenGL"
    filename "OpenGL_Project"
@@ -18,14 +23,32 @@ project "OpenGL"
 
    files { "include/*.hpp", "src/*.cpp", _WORKING_DIR .. "/external/glad/src/glad.c" }
 
-   links { "glfw3", "gdi32", "user32", "kernel32" }
+   includedirs { "include", _WORKING_DIR .. "/external/glad/include", _WORKING_DIR .. "/external/glm-1.0.1" }
+
+   filter "platforms:Win64"
+      system "windows"
+      architecture "x86_64"
+      links { "glfw3", "gdi32", "user32", "kernel32" }
+      libdirs { _WORKING_DIR .. "/external/glfw-3.4-win64/lib-vc2022" }
+      includedirs { _WORKING_DIR .. "/external/glfw-3.4-win64/include" }
 
-   libdirs { _WORKING_DIR .. "/external/glfw-3.4-win64/lib-vc2022" }
+   filter "platforms:Linux64"
+      system "linux"
+      architecture "x86_64"
+      links { "glfw", "EGL", "dl", "pthread" }
 
-   includedirs { "include", _WORKING_DIR .. "/external/glad/include", _WORKING_DIR .. "/external/glfw-3.4-win64/include", _WORKING_DIR .. "/external/glm-1.0.1" }
+   filter {}
 
    debugdir "%{cfg.buildtarget.absolutepath}"
 
+   -- Keeps the vertex kernel's scalar path rounding like glm, see
+   -- Transform_Quads_Scalar. MSVC does not contract under /fp:precise.
+   filter { "files:src/Vertex_Kernel.cpp", "toolset:gcc or clang" }
+      buildoptions { "-ffp-contract=off" }
+
+   filter "options:profile"
+      defines { "PROFILER_ENABLED" }
+
    filter "configurations:Debug"
       defines { "DEBUG" }
       symbols "On"
@@ -0,0 +1,326 @@
+#include "Asset_Pack.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t Align(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// ================================
+// Reading
+// ================================
+static bool Map_File(Asset_Pack::Pack& pack, const std::string& filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data) {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    pack.file = file;
+    pack.mapping = mapping;
+    pack.data = (const uint8_t*) data;
+    pack.size = (size_t) size.QuadPart;
+#else
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status;
+    void* data = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+        data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps the file alive
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    pack.data = (const uint8_t*) data;
+    pack.size = status.st_size;
+#endif
+    return true;
+}
+
+void Asset_Pack::Close(Pack& pack) {
+    if (!pack.data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(pack.data);
+    CloseHandle(pack.mapping);
+    CloseHandle(pack.file);
+#else
+    munmap((void*) pack.data, pack.size);
+#endif
+    pack = Pack {};
+}
+
+bool Asset_Pack::Open(Pack& pack, const std::string& filename) {
+    Close(pack);
+    if (!Map_File(pack, filename)) {
+        printf("Failed to map pack %s\n", filename.c_str());
+        return false;
+    }
+
+    const char* error = nullptr;
+    const Header* header = (const Header*) pack.data;
+    if (pack.size < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+        error = "not a pack";
+    else if (header->version != VERSION)
+        error = "unsupported version";
+    else if (header->file_size != pack.size)
+        error = "truncated";
+    else if (header->table_offset % alignof(Section) != 0 || header->table_offset > pack.size
+             || header->section_count > (pack.size - header->table_offset) / sizeof(Section))
+        error = "bad section table";
+
+    if (!error) {
+        const Section* sections = (const Section*) (pack.data + header->table_offset);
+        for (uint32_t s = 0; s < header->section_count && !error; ++s) {
+            const Section& section = sections[s];
+            if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > pack.size || section.size > pack.size - section.offset)
+                error = "section out of bounds";
+            else if (section.name[MAX_NAME_LENGTH - 1] != '\0')
+                error = "section name too long";
+        }
+        pack.header = header;
+        pack.sections = sections;
+    }
+
+    if (error) {
+        printf("Failed to open pack %s: %s\n", filename.c_str(), error);
+        Close(pack);
+        return false;
+    }
+    return true;
+}
+
+const Asset_Pack::Section* Asset_Pack::Find_Section(const Pack& pack, Section_Type type, const std::string& name) {
+    if (!pack.header)
+        return nullptr;
+
+    for (uint32_t s = 0; s < pack.header->section_count; ++s) {
+        const Section& section = pack.sections[s];
+        if (section.type == type && name == section.name)
+            return &section;
+    }
+    return nullptr;
+}
+
+// True when `count` elements of `element_size` at `offset` lie inside the
+// section and are aligned for their type
+static bool Array_Fits(const Asset_Pack::Section& section, uint64_t offset, uint64_t count, size_t element_size, size_t alignment) {
+    return offset % alignment == 0 && offset <= section.size && count <= (section.size - offset) / element_size;
+}
+
+bool Asset_Pack::Get_Scene(const Pack& pack, const std::string& name, Scene_View& scene) {
+    const Section* section = Find_Section(pack, SECTION_SCENE, name);
+    if (!section || section->size < sizeof(Scene_Header))
+        return false;
+
+    const uint8_t* base = pack.data + section->offset;
+    const Scene_Header& header = *(const Scene_Header*) base;
+    uint32_t count = header.entity_count;
+    uint32_t name_count = header.sprite_name_count;
+
+    bool valid = Array_Fits(*section, header.positions_offset, count, sizeof(glm::vec3), alignof(glm::vec3))
+        && Array_Fits(*section, header.scales_offset, count, sizeof(glm::vec3), alignof(glm::vec3))
+        && Array_Fits(*section, header.tints_offset, count, sizeof(glm::vec3), alignof(glm::vec3))
+        && Array_Fits(*section, header.sprites_offset, count, sizeof(uint32_t), alignof(uint32_t))
+        && Array_Fits(*section, header.name_offsets_offset, name_count, sizeof(uint32_t), alignof(uint32_t))
+        && header.names_offset <= section->size;
+    if (!valid)
+        return false;
+
+    // Names must end inside the section; sprite indices are checked by users
+    const uint32_t* name_offsets = (const uint32_t*) (base + header.name_offsets_offset);
+    const char* names = (const char*) (base + header.names_offset);
+    uint64_t names_size = section->size - header.names_offset;
+    for (uint32_t n = 0; n < name_count; ++n) {
+        if (name_offsets[n] >= names_size || !std::memchr(names + name_offsets[n], '\0', names_size - name_offsets[n]))
+            return false;
+    }
+
+    scene.entity_count = count;
+    scene.positions = (const glm::vec3*) (base + header.positions_offset);
+    scene.scales = (const glm::vec3*) (base + header.scales_offset);
+    scene.tints = (const glm::vec3*) (base + header.tints_offset);
+    scene.sprites = (const uint32_t*) (base + header.sprites_offset);
+    scene.sprite_name_count = name_count;
+    scene.name_offsets = name_offsets;
+    scene.names = names;
+    return true;
+}
+
+bool Asset_Pack::Get_Bodies(const Pack& pack, const std::string& name, Bodies_View& bodies) {
+    const Section* section = Find_Section(pack, SECTION_BODIES, name);
+    if (!section || section->size < sizeof(Bodies_Header))
+        return false;
+
+    const uint8_t* base = pack.data + section->offset;
+    const Bodies_Header& header = *(const Bodies_Header*) base;
+    if (!Array_Fits(*section, header.masses_offset, header.entity_count, sizeof(float), alignof(float)))
+        return false;
+
+    bodies.entity_count = header.entity_count;
+    bodies.masses = (const float*) (base + header.masses_offset);
+    return true;
+}
+
+bool Asset_Pack::Get_Shader_Source(const Pack& pack, const std::string& name, std::string& source) {
+    const Section* section = Find_Section(pack, SECTION_SHADER, name);
+    if (!section)
+        return false;
+
+    source.assign((const char*) (pack.data + section->offset), section->size);
+    return true;
+}
+
+bool Asset_Pack::Get_Texture(const Pack& pack, const std::string& name, Texture_View& texture) {
+    const Section* section = Find_Section(pack, SECTION_TEXTURE, name);
+    if (!section || section->size < sizeof(Texture_Header))
+        return false;
+
+    const Texture_Header& header = *(const Texture_Header*) (pack.data + section->offset);
+    uint64_t pixel_bytes = (uint64_t) header.width * header.height * 4;
+    if (pixel_bytes > section->size - sizeof(Texture_Header))
+        return false;
+
+    texture.width = header.width;
+    texture.height = header.height;
+    texture.pixels = pack.data + section->offset + sizeof(Texture_Header);
+    return true;
+}
+
+// ================================
+// Writing
+// ================================
+uint8_t* Asset_Pack::Pack_Writer::add_section(Section_Type type, const std::string& name, size_t size) {
+    Section section {};
+    snprintf(section.name, sizeof(section.name), "%s", name.c_str());
+    section.type = type;
+    section.offset = Align(data.size(), SECTION_ALIGNMENT);
+    section.size = size;
+    sections.push_back(section);
+
+    data.resize(section.offset + size, 0);
+    return data.data() + section.offset;
+}
+
+void Asset_Pack::Add_Scene(Pack_Writer& writer, const std::string& name, uint32_t entity_count,
+                           const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints,
+                           const uint32_t* sprites, const std::vector<std::string>& sprite_names) {
+    Scene_Header header {};
+    header.entity_count = entity_count;
+    header.sprite_name_count = sprite_names.size();
+
+    // Each array starts on its own cache line
+    uint64_t vec3_bytes = (uint64_t) entity_count * sizeof(glm::vec3);
+    header.positions_offset = Align(sizeof(Scene_Header), SECTION_ALIGNMENT);
+    header.scales_offset = Align(header.positions_offset + vec3_bytes, SECTION_ALIGNMENT);
+    header.tints_offset = Align(header.scales_offset + vec3_bytes, SECTION_ALIGNMENT);
+    header.sprites_offset = Align(header.tints_offset + vec3_bytes, SECTION_ALIGNMENT);
+    header.name_offsets_offset = Align(header.sprites_offset + entity_count * sizeof(uint32_t), SECTION_ALIGNMENT);
+    header.names_offset = header.name_offsets_offset + sprite_names.size() * sizeof(uint32_t);
+
+    uint64_t names_size = 0;
+    for (const std::string& sprite_name : sprite_names)
+        names_size += sprite_name.size() + 1;
+
+    uint8_t* base = writer.add_section(SECTION_SCENE, name, header.names_offset + names_size);
+    std::memcpy(base, &header, sizeof(header));
+    std::memcpy(base + header.positions_offset, positions, vec3_bytes);
+    std::memcpy(base + header.scales_offset, scales, vec3_bytes);
+    std::memcpy(base + header.tints_offset, tints, vec3_bytes);
+
+    uint32_t* sprite_indices = (uint32_t*) (base + header.sprites_offset);
+    for (uint32_t e = 0; e < entity_count; ++e)
+        sprite_indices[e] = sprites ? sprites[e] : NO_SPRITE;
+
+    uint32_t* name_offsets = (uint32_t*) (base + header.name_offsets_offset);
+    uint32_t offset = 0;
+    for (size_t n = 0; n < sprite_names.size(); ++n) {
+        name_offsets[n] = offset;
+        std::memcpy(base + header.names_offset + offset, sprite_names[n].c_str(), sprite_names[n].size() + 1);
+        offset += sprite_names[n].size() + 1;
+    }
+}
+
+void Asset_Pack::Add_Bodies(Pack_Writer& writer, const std::string& name, uint32_t entity_count, const float* masses) {
+    Bodies_Header header {};
+    header.entity_count = entity_count;
+    header.masses_offset = Align(sizeof(Bodies_Header), SECTION_ALIGNMENT);
+
+    uint8_t* base = writer.add_section(SECTION_BODIES, name, header.masses_offset + entity_count * sizeof(float));
+    std::memcpy(base, &header, sizeof(header));
+    std::memcpy(base + header.masses_offset, masses, entity_count * sizeof(float));
+}
+
+void Asset_Pack::Add_Shader(Pack_Writer& writer, const std::string& name, const std::string& source) {
+    uint8_t* destination = writer.add_section(SECTION_SHADER, name, source.size());
+    std::memcpy(destination, source.data(), source.size());
+}
+
+void Asset_Pack::Add_Texture(Pack_Writer& writer, const std::string& name, int width, int height, const uint8_t* pixels) {
+    size_t pixel_bytes = (size_t) width * height * 4;
+    uint8_t* destination = writer.add_section(SECTION_TEXTURE, name, sizeof(Texture_Header) + pixel_bytes);
+
+    Texture_Header header { (uint32_t) width, (uint32_t) height };
+    std::memcpy(destination, &header, sizeof(header));
+    std::memcpy(destination + sizeof(header), pixels, pixel_bytes);
+}
+
+bool Asset_Pack::Write_Pack(const Pack_Writer& writer, const std::string& filename) {
+    uint64_t table_offset = sizeof(Header);
+    uint64_t data_offset = Align(table_offset + writer.sections.size() * sizeof(Section), SECTION_ALIGNMENT);
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.section_count = writer.sections.size();
+    header.table_offset = table_offset;
+    header.file_size = data_offset + writer.data.size();
+
+    // Section offsets were relative to the data block
+    std::vector<Section> sections = writer.sections;
+    for (Section& section : sections)
+        section.offset += data_offset;
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        printf("Failed to write pack %s\n", filename.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> padding(data_offset - table_offset - sections.size() * sizeof(Section), 0);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && (sections.empty() || fwrite(sections.data(), sizeof(Section), sections.size(), file) == sections.size())
+        && (padding.empty() || fwrite(padding.data(), 1, padding.size(), file) == padding.size())
+        && (writer.data.empty() || fwrite(writer.data.data(), 1, writer.data.size(), file) == writer.data.size());
+    written = fclose(file) == 0 && written;
+
+    if (!written)
+        printf("Failed to write pack %s\n", filename.c_str());
+    return written;
+}
\ No newline at end of file
@@ -11,11 +11,5 @@ Player::Player(glm::vec3 position) {
 }
 
 void Player::update_render() {
-    Vertex_Buffer& buffer = sprite.buffer;
-
-    glm::mat4 matrix = glm::mat4(1.0f);
-    matrix = glm::translate(matrix, transform.position);
-    matrix = glm::scale(matrix, transform.scale);
-
-    sprite.update_buffer(matrix);
+    sprite.update_buffer(transform.position, transform.scale);
 }
\ No newline at end of file
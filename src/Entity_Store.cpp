@@ -0,0 +1,339 @@
+#include "Entity_Store.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include "Job_System.hpp"
+#include "Profiler.hpp"
+
+using Vertex_Kernel::QUAD_SIZE;
+
+// Entities per block when building a culled subset or moving in parallel
+constexpr int GATHER_SIZE = 256;
+// build_changes rebuilds every entity once more than 1 / FULL_REBUILD_SHARE of
+// them changed
+constexpr size_t FULL_REBUILD_SHARE = 16;
+
+// Sprite quads span -0.5 to 0.5 before scaling
+static void Quad_Bounds(glm::vec3 position, glm::vec3 scale, glm::vec2& min, glm::vec2& max) {
+    glm::vec2 center(position.x, position.y);
+    glm::vec2 half_extent = glm::abs(glm::vec2(scale.x, scale.y)) * 0.5f;
+    min = center - half_extent;
+    max = center + half_extent;
+}
+
+Entity_Handle Entity_Store::create(glm::vec3 position, glm::vec3 scale, glm::vec3 tint) {
+    uint32_t slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else {
+        slot = slot_to_index.size();
+        slot_to_index.push_back(0);
+        slot_generation.push_back(0);
+    }
+
+    slot_to_index[slot] = positions.size();
+    index_to_slot.push_back(slot);
+
+    positions.push_back(position);
+    scales.push_back(scale);
+    tints.push_back(tint);
+
+    changed.push_back(0);
+    mark_changed(positions.size() - 1);
+
+    glm::vec2 min, max;
+    Quad_Bounds(position, scale, min, max);
+    grid.insert(slot, min, max);
+
+    return { slot, slot_generation[slot] };
+}
+
+void Entity_Store::destroy(Entity_Handle handle) {
+    if (!is_alive(handle))
+        return;
+
+    uint32_t index = slot_to_index[handle.slot];
+    uint32_t last = positions.size() - 1;
+
+    // Move the last entity into the freed index to keep the pools dense
+    positions[index] = positions[last];
+    scales[index] = scales[last];
+    tints[index] = tints[last];
+    index_to_slot[index] = index_to_slot[last];
+    slot_to_index[index_to_slot[index]] = index;
+
+    positions.pop_back();
+    scales.pop_back();
+    tints.pop_back();
+    index_to_slot.pop_back();
+
+    // The moved entity now draws from the freed index
+    changed.pop_back();
+    if (index < last)
+        mark_changed(index);
+    removed = true;
+
+    grid.remove(handle.slot);
+
+    slot_generation[handle.slot]++;
+    free_slots.push_back(handle.slot);
+}
+
+void Entity_Store::set_transform(Entity_Handle handle, glm::vec3 position, glm::vec3 scale) {
+    if (!is_alive(handle))
+        return;
+
+    uint32_t index = slot_to_index[handle.slot];
+    positions[index] = position;
+    scales[index] = scale;
+
+    glm::vec2 min, max;
+    Quad_Bounds(position, scale, min, max);
+    grid.move(handle.slot, min, max);
+
+    mark_changed(index);
+}
+
+void Entity_Store::set_tint(Entity_Handle handle, glm::vec3 tint) {
+    if (!is_alive(handle))
+        return;
+
+    uint32_t index = slot_to_index[handle.slot];
+    tints[index] = tint;
+    mark_changed(index);
+}
+
+void Entity_Store::move_parallel(int grain, const std::function<void(int, int, glm::vec3*)>& move) {
+    PROFILE_ZONE("move entities");
+    glm::vec3* data = positions.data();
+    std::mutex merge_mutex;
+    moved_indices.clear();
+    crossing_indices.clear();
+
+    // Each slice moves its entities in blocks, keeping the positions before
+    // the move to find the ones that changed. Their grid bounds and change
+    // flags are updated in place; only the new changes and the entities that
+    // need the cell lists touched are gathered for the calling thread.
+    Jobs::Parallel_For(size(), grain, [this, &move, &merge_mutex, data](int first, int count) {
+        std::vector<uint32_t> moved;
+        std::vector<uint32_t> crossing;
+        glm::vec3 previous[GATHER_SIZE];
+
+        for (int start = first; start < first + count; start += GATHER_SIZE) {
+            int block = std::min(GATHER_SIZE, first + count - start);
+            std::copy(data + start, data + start + block, previous);
+            move(start, block, data);
+
+            for (int i = 0; i < block; ++i) {
+                uint32_t index = start + i;
+                if (data[index] == previous[i])
+                    continue;
+
+                glm::vec2 min, max;
+                Quad_Bounds(data[index], scales[index], min, max);
+                if (!grid.move_in_place(index_to_slot[index], min, max))
+                    crossing.push_back(index);
+                if (!changed[index]) {
+                    changed[index] = 1;
+                    moved.push_back(index);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        moved_indices.insert(moved_indices.end(), moved.begin(), moved.end());
+        crossing_indices.insert(crossing_indices.end(), crossing.begin(), crossing.end());
+    });
+
+    changed_indices.insert(changed_indices.end(), moved_indices.begin(), moved_indices.end());
+    for (uint32_t index : crossing_indices) {
+        glm::vec2 min, max;
+        Quad_Bounds(positions[index], scales[index], min, max);
+        grid.move(index_to_slot[index], min, max);
+    }
+}
+
+void Entity_Store::mark_changed(uint32_t index) {
+    if (changed[index])
+        return;
+    changed[index] = 1;
+    changed_indices.push_back(index);
+}
+
+void Entity_Store::build_changes(Renderer::Resident_Batch& batch) {
+    PROFILE_ZONE("build changes");
+    std::vector<float>& stream = batch.buffer.stream;
+    stream.resize(size() * QUAD_SIZE);
+    batch.sprite_count = size();
+
+    // Past a point, sorting the changes costs more than rebuilding everything
+    if (changed_indices.size() > (size_t) size() / FULL_REBUILD_SHARE) {
+        build_vertices(stream.data(), 0, size());
+        batch.dirty.clear();
+        batch.mark_dirty(0, size());
+        clear_changes();
+        return;
+    }
+
+    // Indices past the end belong to entities destroyed since they changed,
+    // and an index can repeat if it was freed and reused
+    std::sort(changed_indices.begin(), changed_indices.end());
+    changed_indices.erase(std::unique(changed_indices.begin(), changed_indices.end()), changed_indices.end());
+    while (!changed_indices.empty() && changed_indices.back() >= (uint32_t) size())
+        changed_indices.pop_back();
+
+    // Build consecutive indices with one kernel call each
+    for (size_t i = 0; i < changed_indices.size();) {
+        uint32_t first = changed_indices[i];
+        size_t end = i + 1;
+        while (end < changed_indices.size() && changed_indices[end] == changed_indices[end - 1] + 1)
+            end++;
+
+        int count = end - i;
+        build_vertices(stream.data() + first * QUAD_SIZE, first, count);
+        batch.mark_dirty(first, count);
+        i = end;
+    }
+
+    clear_changes();
+}
+
+void Entity_Store::clear_changes() {
+    for (uint32_t index : changed_indices) {
+        if (index < changed.size())
+            changed[index] = 0;
+    }
+    changed_indices.clear();
+    removed = false;
+}
+
+bool Entity_Store::is_alive(Entity_Handle handle) const {
+    return handle.slot < slot_generation.size() && slot_generation[handle.slot] == handle.generation;
+}
+
+uint32_t Entity_Store::index_of(Entity_Handle handle) const {
+    return slot_to_index[handle.slot];
+}
+
+Entity_Handle Entity_Store::handle_of(uint32_t index) const {
+    uint32_t slot = index_to_slot[index];
+    return { slot, slot_generation[slot] };
+}
+
+// Writes interleaved position/color vertices for entities [first, first + count)
+// in the layout of Sprite::update_buffer.
+void Entity_Store::build_vertices(float* stream, int first, int count) const {
+    Vertex_Kernel::Transform_Quads(positions.data() + first, scales.data() + first, tints.data() + first, count, stream);
+}
+
+void Entity_Store::build_batch(Renderer::Sprite_Batch& batch) const {
+    std::vector<float>& stream = batch.buffer.stream;
+    stream.resize(size() * QUAD_SIZE);
+    batch.sprite_count = size();
+
+    build_vertices(stream.data(), 0, size());
+}
+
+void Entity_Store::build_vertices_parallel(std::vector<float>& stream) const {
+    stream.resize(size() * QUAD_SIZE);
+    build_vertices_parallel(stream.data());
+}
+
+void Entity_Store::build_vertices_parallel(float* destination) const {
+    PROFILE_ZONE("build vertices");
+    Jobs::Parallel_For(size(), 4096, [this, destination](int first, int count) {
+        build_vertices(destination + first * QUAD_SIZE, first, count);
+    });
+}
+
+void Entity_Store::build_instances_parallel(std::vector<Renderer::Instance>& instances) const {
+    PROFILE_ZONE("build instances");
+    instances.resize(size());
+    Renderer::Instance* destination = instances.data();
+    Jobs::Parallel_For(size(), 4096, [this, destination](int first, int count) {
+        for (int e = first; e < first + count; ++e) {
+            destination[e] = { positions[e], scales[e], tints[e], glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) };
+        }
+    });
+}
+
+void Entity_Store::cull(glm::vec2 view_min, glm::vec2 view_max) {
+    query_slots.clear();
+    grid.query(view_min, view_max, query_slots);
+
+    visible.resize(query_slots.size());
+    for (size_t i = 0; i < query_slots.size(); ++i)
+        visible[i] = slot_to_index[query_slots[i]];
+
+    // Walk the component arrays front to back when building
+    std::sort(visible.begin(), visible.end());
+}
+
+void Entity_Store::build_visible_parallel(std::vector<float>& stream) const {
+    stream.resize(visible.size() * QUAD_SIZE);
+    build_visible_parallel(stream.data());
+}
+
+void Entity_Store::build_visible_parallel(float* destination) const {
+    PROFILE_ZONE("build visible");
+    Jobs::Parallel_For(visible.size(), 4096, [this, destination](int first, int count) {
+        glm::vec3 gathered_positions[GATHER_SIZE];
+        glm::vec3 gathered_scales[GATHER_SIZE];
+        glm::vec3 gathered_tints[GATHER_SIZE];
+
+        for (int start = first; start < first + count; start += GATHER_SIZE) {
+            int gathered = std::min(GATHER_SIZE, first + count - start);
+            for (int i = 0; i < gathered; ++i) {
+                uint32_t index = visible[start + i];
+                gathered_positions[i] = positions[index];
+                gathered_scales[i] = scales[index];
+                gathered_tints[i] = tints[index];
+            }
+
+            Vertex_Kernel::Transform_Quads(gathered_positions, gathered_scales, gathered_tints, gathered, destination + start * QUAD_SIZE);
+        }
+    });
+}
+
+Entity_Handle Entity_Store::pick(glm::vec2 point) const {
+    query_slots.clear();
+    grid.query(point, point, query_slots);
+
+    // Sprites are built in dense order, so the highest index is drawn last
+    uint32_t picked = UINT32_MAX;
+    for (uint32_t slot : query_slots) {
+        uint32_t index = slot_to_index[slot];
+        if (picked == UINT32_MAX || index > picked)
+            picked = index;
+    }
+
+    return picked == UINT32_MAX ? Entity_Handle {} : handle_of(picked);
+}
+
+void Entity_Store::select(glm::vec2 box_min, glm::vec2 box_max, std::vector<Entity_Handle>& selection) const {
+    query_slots.clear();
+    grid.query(box_min, box_max, query_slots);
+
+    for (uint32_t slot : query_slots)
+        selection.push_back({ slot, slot_generation[slot] });
+}
+
+void Entity_Store::load(const Asset_Pack::Scene_View& scene) {
+    size_t total = positions.size() + scene.entity_count;
+    positions.reserve(total);
+    scales.reserve(total);
+    tints.reserve(total);
+    index_to_slot.reserve(total);
+    changed.reserve(total);
+    changed_indices.reserve(total);
+
+    for (uint32_t e = 0; e < scene.entity_count; ++e)
+        create(scene.positions[e], scene.scales[e], scene.tints[e]);
+}
+
+void Entity_Store::save(Asset_Pack::Pack_Writer& writer, const std::string& name) const {
+    Asset_Pack::Add_Scene(writer, name, size(), positions.data(), scales.data(), tints.data(), nullptr, {});
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "Extensions.hpp"
+
+#include <cstring>
+
+namespace Renderer {
+    Extensions extensions;
+
+    PFNGLBUFFERSTORAGEPROC gl_buffer_storage = nullptr;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC gl_max_shader_compiler_threads = nullptr;
+}
+
+bool Renderer::Has_Extension(const char* name) {
+    GLint extension_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+    for (GLint i = 0; i < extension_count; ++i) {
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+void Renderer::Load_Extensions(GLADloadproc load) {
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool is_gl_44 = major > 4 || (major == 4 && minor >= 4);
+
+    if (is_gl_44 || Has_Extension("GL_ARB_buffer_storage")) {
+        gl_buffer_storage = (PFNGLBUFFERSTORAGEPROC) load("glBufferStorage");
+        extensions.buffer_storage = gl_buffer_storage != nullptr;
+    }
+
+    // Lets the driver compile shaders on its own threads
+    if (Has_Extension("GL_KHR_parallel_shader_compile"))
+        gl_max_shader_compiler_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsKHR");
+    else if (Has_Extension("GL_ARB_parallel_shader_compile"))
+        gl_max_shader_compiler_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsARB");
+
+    if (gl_max_shader_compiler_threads) {
+        gl_max_shader_compiler_threads(0xFFFFFFFF);
+        extensions.parallel_shader_compile = true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,596 @@
+#include "Headless.hpp"
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Renderer.hpp"
+#include "Render_Queue.hpp"
+#include "Entity_Store.hpp"
+#include "Job_System.hpp"
+#include "Profiler.hpp"
+#include "Text.hpp"
+#include "Tilemap.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// GPU timer results are read this many frames late so reading never stalls
+constexpr int QUERY_LATENCY = 4;
+// Frames run before recording starts, so first-use costs (shader and buffer
+// setup in the driver) do not skew the results
+constexpr int WARMUP_FRAMES = 10;
+// The tilemap is drawn under the entities and scrolls diagonally
+constexpr uint16_t TILEMAP_LAYER = 0;
+constexpr uint16_t SCENE_LAYER = 1;
+constexpr float TILE_SIZE = 8.0f;
+constexpr float SCROLL_SPEED = 3.0f;
+
+struct Context {
+    GLFWwindow* window = nullptr;
+#ifdef __linux__
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#endif
+    const char* type = "none";
+};
+
+#ifdef __linux__
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static bool Create_EGL_Context(Context& context) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        return false;
+
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        eglTerminate(display);
+        return false;
+    }
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    eglBindAPI(EGL_OPENGL_API);
+    EGLContext egl_context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT) {
+        eglTerminate(display);
+        return false;
+    }
+
+    // No surface at all; everything renders into the framebuffer object
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+        eglDestroyContext(display, egl_context);
+        eglTerminate(display);
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, egl_context);
+        eglTerminate(display);
+        return false;
+    }
+    Renderer::Load_Extensions((GLADloadproc) eglGetProcAddress);
+
+    context.display = display;
+    context.context = egl_context;
+    context.type = "egl_surfaceless";
+    return true;
+}
+#endif
+
+static bool Create_GLFW_Context(Context& context, Headless::Options& options) {
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    context.window = glfwCreateWindow(options.width, options.height, "OpenGL", NULL, NULL);
+    if (context.window == NULL) {
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(context.window);
+
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        glfwDestroyWindow(context.window);
+        context.window = nullptr;
+        glfwTerminate();
+        return false;
+    }
+    Renderer::Load_Extensions((GLADloadproc) glfwGetProcAddress);
+
+    context.type = "glfw_hidden_window";
+    return true;
+}
+
+static void Destroy_Context(Context& context) {
+#ifdef __linux__
+    if (context.context != EGL_NO_CONTEXT) {
+        eglMakeCurrent(context.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(context.display, context.context);
+        eglTerminate(context.display);
+    }
+#endif
+    if (context.window)
+        glfwTerminate();
+}
+
+struct Timing_Stats {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+static Timing_Stats Compute_Stats(std::vector<double> samples) {
+    Timing_Stats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        return samples[(size_t) (p * (samples.size() - 1) + 0.5)];
+    };
+
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+
+    stats.mean = total / samples.size();
+    stats.p50 = percentile(0.50);
+    stats.p90 = percentile(0.90);
+    stats.p99 = percentile(0.99);
+    stats.min = samples.front();
+    stats.max = samples.back();
+    return stats;
+}
+
+static void Write_Stats(FILE* file, const char* name, const Timing_Stats& stats, bool last) {
+    fprintf(file, "  \"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"min\": %.4f, \"max\": %.4f }%s\n",
+        name, stats.mean, stats.p50, stats.p90, stats.p99, stats.min, stats.max, last ? "" : ",");
+}
+
+bool Headless::Parse_Arguments(int argc, char** argv, Options& options) {
+    bool headless = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && has_value)
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--entities") == 0 && has_value)
+            options.entities = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--static") == 0 && has_value)
+            options.static_fraction = std::clamp((float) std::atof(argv[++i]), 0.0f, 1.0f);
+        else if (std::strcmp(argv[i], "--text") == 0 && has_value)
+            options.text = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--tilemap") == 0 && has_value)
+            options.tilemap = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--instanced") == 0)
+            options.instanced = true;
+        else if (std::strcmp(argv[i], "--output") == 0 && has_value)
+            options.output = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && has_value)
+            options.trace = argv[++i];
+    }
+
+    return headless;
+}
+
+int Headless::Run(Options& options) {
+    Context context;
+    bool created = false;
+#ifdef __linux__
+    created = Create_EGL_Context(context);
+#endif
+    if (!created)
+        created = Create_GLFW_Context(context, options);
+    if (!created) {
+        printf("Failed to create a headless GL context\n");
+        return -1;
+    }
+
+    printf("Headless context: %s, %s\n", context.type, (const char*) glGetString(GL_RENDERER));
+
+    // Offscreen render target
+    GLuint framebuffer, color_target;
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &color_target);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_target);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_target);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Headless framebuffer is incomplete\n");
+        Destroy_Context(context);
+        return -1;
+    }
+
+    glViewport(0, 0, options.width, options.height);
+    glClearColor(0.75f, 0.75f, 0.75f, 1.0f);
+
+    // Every shader is queued before the first is used, so their compiles
+    // overlap. The map's own copy of the color shader follows the scrolling
+    // view, while the entities stay fixed on screen.
+    Renderer::Shader_Handle color_shader = Renderer::Create_Shader("color");
+    Renderer::Shader_Handle text_shader;
+    if (options.text > 0)
+        text_shader = Renderer::Create_Shader("text");
+    Renderer::Shader_Handle tile_shader;
+    if (options.tilemap > 0)
+        tile_shader = Renderer::Create_Shader("tiles", "color", "color");
+    Renderer::Shader_Handle instanced_shader;
+    if (options.instanced)
+        instanced_shader = Renderer::Create_Shader("color_instanced", "color_instanced", "color");
+    Renderer::Wait_Shaders();
+
+    glUseProgram(Renderer::Get_Shader(color_shader));
+    GLint ortho_location = glGetUniformLocation(Renderer::Get_Shader(color_shader), "ortho_transform");
+    glm::mat4 ortho_transform = glm::ortho(0.0f, (float) options.width, 0.0f, (float) options.height, 0.0f, -100.0f);
+    glUniformMatrix4fv(ortho_location, 1, GL_FALSE, glm::value_ptr(ortho_transform));
+    if (options.instanced) {
+        glUseProgram(Renderer::Get_Shader(instanced_shader));
+        glUniformMatrix4fv(glGetUniformLocation(Renderer::Get_Shader(instanced_shader), "ortho_transform"), 1, GL_FALSE, glm::value_ptr(ortho_transform));
+    }
+    glUseProgram(0);
+
+    // Synthetic scene, seeded so every run draws the same thing
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> x_coordinate(0.0f, (float) options.width);
+    std::uniform_real_distribution<float> y_coordinate(0.0f, (float) options.height);
+    std::uniform_real_distribution<float> size(4.0f, 32.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Static entities are uploaded once; the rest move every frame
+    int static_count = (int) (options.entities * options.static_fraction);
+    Entity_Store scenery;
+    Entity_Store entities;
+    for (int i = 0; i < options.entities; ++i) {
+        float side = size(rng);
+        Entity_Store& store = i < static_count ? scenery : entities;
+        store.create(glm::vec3(x_coordinate(rng), y_coordinate(rng), 0.0f),
+                     glm::vec3(side, side, 1.0f),
+                     glm::vec3(unit(rng), unit(rng), unit(rng)));
+    }
+
+    // The moving entities stream through one of these, see options.instanced
+    Renderer::Sprite_Batch sprite_batch;
+    Renderer::Instance_Batch instance_batch;
+    if (options.instanced)
+        Renderer::Initialize_Instanced("instances", instanced_shader, instance_batch, std::max(1, entities.size()));
+    else
+        Renderer::Initialize_Batch("sprites", color_shader, sprite_batch, std::max(1, entities.size()));
+    Renderer::Resident_Batch scenery_batch;
+    Renderer::Initialize_Resident("scenery", color_shader, scenery_batch, std::max(1, scenery.size()), GL_STATIC_DRAW);
+    scenery.build_changes(scenery_batch);
+    Renderer::Render_Queue render_queue;
+
+    // A paragraph of options.text glyphs whose layout stays cached, and a
+    // frame counter laid out anew every frame
+    Renderer::Glyph_Atlas glyph_atlas;
+    Renderer::Sprite_Batch text_batch;
+    Renderer::Text_Cache text_cache;
+    Renderer::Text paragraph;
+    Renderer::Text counter;
+    if (options.text > 0) {
+        glUseProgram(Renderer::Get_Shader(text_shader));
+        glUniformMatrix4fv(glGetUniformLocation(Renderer::Get_Shader(text_shader), "ortho_transform"), 1, GL_FALSE, glm::value_ptr(ortho_transform));
+        glUseProgram(0);
+
+        Renderer::Build_Glyph_Atlas(glyph_atlas);
+        Renderer::Upload_Glyph_Atlas(glyph_atlas);
+        Renderer::Initialize_Batch("text", text_shader, text_batch, options.text + 64, TEXTURED_SPRITE_FORMAT);
+
+        const char* words[] = { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog" };
+        for (int word = 0; (int) paragraph.string.size() < options.text; ++word)
+            paragraph.string += std::string(words[word % 8]) + " ";
+        paragraph.string.resize(options.text);
+        paragraph.position = { 8.0f, options.height - 40.0f };
+        paragraph.size = 8.0f;
+        paragraph.max_width = options.width - 16.0f;
+        paragraph.color = { 0.1f, 0.1f, 0.1f };
+        counter.position = { 8.0f, options.height - 8.0f };
+        counter.size = 24.0f;
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    GLint tile_ortho_location = -1;
+    Renderer::Tilemap tilemap;
+    if (options.tilemap > 0) {
+        tile_ortho_location = glGetUniformLocation(Renderer::Get_Shader(tile_shader), "ortho_transform");
+
+        tilemap.tile_size = TILE_SIZE;
+        tilemap.resize(options.tilemap, options.tilemap);
+        tilemap.palette.push_back(0);
+        for (int color = 0; color < 15; ++color)
+            tilemap.palette.push_back(Vertex_Kernel::Pack_Color(glm::vec3(unit(rng), unit(rng), unit(rng))));
+        // One tile in four is empty
+        std::uniform_int_distribution<int> tile_id(-4, 15);
+        for (uint16_t& tile : tilemap.tiles)
+            tile = (uint16_t) std::max(tile_id(rng), 0);
+
+        Renderer::Initialize_Tilemap("tilemap", tile_shader, tilemap);
+    }
+    glm::vec2 view_size((float) options.width, (float) options.height);
+    float scroll_range = std::max(tilemap.width * TILE_SIZE - std::max(view_size.x, view_size.y), 1.0f);
+
+    // Tile edits waiting to reach the GPU, and how long those that did took
+    struct Tile_Edit {
+        uint32_t chunk;
+        uint32_t revision;
+        Clock::time_point time;
+    };
+    std::vector<Tile_Edit> tile_edits;
+    std::vector<double> edit_latencies;
+    size_t total_chunks_drawn = 0;
+
+    Profiler::Initialize(color_shader);
+    Profiler::Set_Thread_Name("main");
+
+    Jobs::Initialize();
+    Jobs::Counter simulation;
+    std::vector<float> next_vertices;
+    if (options.instanced) {
+        entities.build_instances_parallel(instance_batch.instances);
+    }
+    else {
+        entities.build_vertices_parallel(sprite_batch.buffer.stream);
+        sprite_batch.sprite_count = entities.size();
+    }
+
+    GLuint queries[QUERY_LATENCY];
+    glGenQueries(QUERY_LATENCY, queries);
+
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+    cpu_times.reserve(options.frames);
+    gpu_times.reserve(options.frames);
+    size_t total_bytes_uploaded = 0;
+    int total_fence_waits = 0;
+    int total_draw_calls = 0;
+    int total_buffer_updates = 0;
+
+    float width = (float) options.width;
+    Clock::time_point run_start = Clock::now();
+
+    int frame_count = WARMUP_FRAMES + options.frames;
+    for (int frame = 0; frame < frame_count; ++frame) {
+        Profiler::Begin_Frame();
+        Clock::time_point frame_start = Clock::now();
+        if (frame == WARMUP_FRAMES)
+            run_start = frame_start;
+
+        // The timer query reused this frame was issued QUERY_LATENCY frames ago
+        GLuint query = queries[frame % QUERY_LATENCY];
+        if (frame - QUERY_LATENCY >= WARMUP_FRAMES) {
+            GLuint64 elapsed_ns = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+            gpu_times.push_back(elapsed_ns / 1.0e6);
+        }
+
+        glm::vec2 view_min(std::fmod(frame * SCROLL_SPEED, scroll_range));
+        if (options.tilemap > 0) {
+            // Edits land between uploads and builds, while no job reads tiles
+            std::uniform_real_distribution<float> view_x(view_min.x, view_min.x + view_size.x);
+            std::uniform_real_distribution<float> view_y(view_min.y, view_min.y + view_size.y);
+            // Maps smaller than the view are edited only where they are
+            int x = std::min((int) (view_x(rng) / TILE_SIZE), tilemap.width - 1);
+            int y = std::min((int) (view_y(rng) / TILE_SIZE), tilemap.height - 1);
+            uint16_t tile = (uint16_t) (tilemap.get(x, y) % 15 + 1);
+            tilemap.set(x, y, tile);
+
+            uint32_t chunk = tilemap.chunk_of(x, y);
+            tile_edits.push_back({ chunk, tilemap.chunks[chunk].revision, Clock::now() });
+
+            Renderer::Update_Tilemap(tilemap, view_min, view_min + view_size);
+        }
+
+        Renderer::Begin_Frame();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (options.tilemap > 0) {
+            glm::mat4 view_transform = glm::ortho(view_min.x, view_min.x + view_size.x, view_min.y, view_min.y + view_size.y, 0.0f, -100.0f);
+            glUseProgram(Renderer::Get_Shader(tile_shader));
+            glUniformMatrix4fv(tile_ortho_location, 1, GL_FALSE, glm::value_ptr(view_transform));
+            glUseProgram(0);
+            Renderer::Submit_Tilemap(render_queue, tile_shader, tilemap, TILEMAP_LAYER);
+        }
+        Renderer::Submit_Resident(render_queue, color_shader, scenery_batch, SCENE_LAYER);
+        // Instances are uploaded on submit, so the job can rebuild them.
+        // Vertices of the next positions are built straight into the ring
+        // segment after the one just submitted, or into next_vertices when it
+        // has no room.
+        float* next_mapped = nullptr;
+        if (options.instanced) {
+            Renderer::Submit_Instanced(render_queue, instanced_shader, instance_batch, SCENE_LAYER);
+        }
+        else {
+            Renderer::Submit_Batch(render_queue, color_shader, sprite_batch, SCENE_LAYER);
+            next_mapped = Renderer::Map_Batch(sprite_batch, entities.size());
+        }
+        bool instanced = options.instanced;
+        Jobs::Run(simulation, [&entities, &instance_batch, &next_vertices, next_mapped, instanced, width] {
+            PROFILE_ZONE("update");
+            entities.move_parallel(4096, [width](int first, int count, glm::vec3* positions) {
+                for (int e = first; e < first + count; ++e) {
+                    glm::vec3& position = positions[e];
+                    position.x += 1.0f + (e % 7);
+                    if (position.x > width)
+                        position.x -= width;
+                }
+            });
+            if (instanced)
+                entities.build_instances_parallel(instance_batch.instances);
+            else if (next_mapped)
+                entities.build_vertices_parallel(next_mapped);
+            else
+                entities.build_vertices_parallel(next_vertices);
+        });
+
+        if (options.text > 0) {
+            PROFILE_ZONE("text");
+            counter.string = "frame " + std::to_string(frame);
+            text_batch.clear();
+            Renderer::Add_Text(text_batch, text_cache, glyph_atlas, paragraph);
+            Renderer::Add_Text(text_batch, text_cache, glyph_atlas, counter);
+            text_cache.end_frame();
+            Renderer::Submit_Batch(render_queue, text_shader, text_batch, Renderer::TEXT_LAYER, glyph_atlas.texture);
+        }
+        Renderer::Flush_Queue(render_queue);
+
+        glEndQuery(GL_TIME_ELAPSED);
+        glFlush();
+
+        Jobs::Wait(simulation);
+        if (next_mapped) {
+            Renderer::Commit_Batch(sprite_batch, entities.size());
+        }
+        else if (!options.instanced) {
+            sprite_batch.buffer.stream.swap(next_vertices);
+            sprite_batch.sprite_count = entities.size();
+            sprite_batch.unchanged = false;
+        }
+
+        // An edit is visible once its chunk's new mesh is uploaded, drawn the
+        // next frame
+        if (options.tilemap > 0) {
+            Renderer::Upload_Tilemap(tilemap);
+            Clock::time_point uploaded = Clock::now();
+            size_t waiting = 0;
+            for (const Tile_Edit& edit : tile_edits) {
+                if (tilemap.chunks[edit.chunk].uploaded_revision < edit.revision)
+                    tile_edits[waiting++] = edit;
+                else if (frame >= WARMUP_FRAMES)
+                    edit_latencies.push_back(std::chrono::duration<double, std::milli>(uploaded - edit.time).count());
+            }
+            tile_edits.resize(waiting);
+        }
+        Profiler::End_Frame();
+
+        if (frame < WARMUP_FRAMES)
+            continue;
+
+        total_bytes_uploaded += Renderer::frame_stats.bytes_uploaded;
+        total_fence_waits += Renderer::frame_stats.fence_waits;
+        total_draw_calls += Renderer::frame_stats.draw_calls;
+        total_buffer_updates += Renderer::frame_stats.buffer_updates;
+        for (uint32_t chunk : tilemap.visible)
+            total_chunks_drawn += tilemap.chunks[chunk].slot >= 0;
+
+        cpu_times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frame_start).count());
+    }
+
+    // Collect the queries still in flight
+    glFinish();
+    int first_pending = std::max(WARMUP_FRAMES, frame_count - QUERY_LATENCY);
+    for (int frame = first_pending; frame < frame_count; ++frame) {
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(queries[frame % QUERY_LATENCY], GL_QUERY_RESULT, &elapsed_ns);
+        gpu_times.push_back(elapsed_ns / 1.0e6);
+    }
+
+    double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - run_start).count();
+    Timing_Stats cpu_stats = Compute_Stats(cpu_times);
+    Timing_Stats gpu_stats = Compute_Stats(gpu_times);
+    Timing_Stats edit_stats = Compute_Stats(edit_latencies);
+
+    FILE* file = fopen(options.output.c_str(), "w");
+    if (file) {
+        fprintf(file, "{\n");
+        fprintf(file, "  \"context\": \"%s\",\n", context.type);
+        fprintf(file, "  \"renderer\": \"%s\",\n", (const char*) glGetString(GL_RENDERER));
+        fprintf(file, "  \"frames\": %d,\n", options.frames);
+        fprintf(file, "  \"entities\": %d,\n", options.entities);
+        fprintf(file, "  \"static_entities\": %d,\n", static_count);
+        fprintf(file, "  \"text_glyphs\": %d,\n", options.text);
+        fprintf(file, "  \"tilemap_size\": %d,\n", options.tilemap);
+        fprintf(file, "  \"instanced\": %s,\n", options.instanced ? "true" : "false");
+        fprintf(file, "  \"width\": %d,\n", options.width);
+        fprintf(file, "  \"height\": %d,\n", options.height);
+        fprintf(file, "  \"threads\": %d,\n", Jobs::Thread_Count());
+        fprintf(file, "  \"total_ms\": %.3f,\n", total_ms);
+        fprintf(file, "  \"shader_startup_ms\": %.3f,\n", Renderer::shader_stats.startup_ms);
+        fprintf(file, "  \"shaders_compiled\": %d,\n", Renderer::shader_stats.compiled);
+        fprintf(file, "  \"shader_cache_hits\": %d,\n", Renderer::shader_stats.cache_hits);
+        fprintf(file, "  \"draw_calls_per_frame\": %.2f,\n", (double) total_draw_calls / options.frames);
+        fprintf(file, "  \"bytes_uploaded_per_frame\": %.1f,\n", (double) total_bytes_uploaded / options.frames);
+        fprintf(file, "  \"buffer_updates_per_frame\": %.2f,\n", (double) total_buffer_updates / options.frames);
+        fprintf(file, "  \"fence_waits\": %d,\n", total_fence_waits);
+        fprintf(file, "  \"tilemap_chunks_per_frame\": %.2f,\n", (double) total_chunks_drawn / options.frames);
+        Write_Stats(file, "tile_edit_latency_ms", edit_stats, false);
+        Write_Stats(file, "cpu_frame_ms", cpu_stats, false);
+        Write_Stats(file, "gpu_frame_ms", gpu_stats, true);
+        fprintf(file, "}\n");
+        fclose(file);
+    }
+    else {
+        printf("Failed to open %s\n", options.output.c_str());
+    }
+
+    printf("%d frames, %d entities: cpu %.3f ms (p99 %.3f), gpu %.3f ms (p99 %.3f), fence waits %d\n",
+        options.frames, options.entities, cpu_stats.mean, cpu_stats.p99, gpu_stats.mean, gpu_stats.p99, total_fence_waits);
+    printf("%s: %.1f KB uploaded per frame\n",
+        options.instanced ? "instanced" : "streamed", total_bytes_uploaded / 1024.0 / options.frames);
+
+    if (options.tilemap > 0)
+        printf("%dx%d tilemap: %.1f chunks drawn, edit to upload %.3f ms (p99 %.3f)\n",
+            options.tilemap, options.tilemap, (double) total_chunks_drawn / options.frames, edit_stats.mean, edit_stats.p99);
+
+    if (!options.trace.empty() && Profiler::Write_Trace(options.trace))
+        printf("trace saved to %s\n", options.trace.c_str());
+
+    Jobs::Shutdown();
+    glDeleteQueries(QUERY_LATENCY, queries);
+    glDeleteRenderbuffers(1, &color_target);
+    glDeleteFramebuffers(1, &framebuffer);
+    Destroy_Context(context);
+
+    return file ? 0 : -1;
+}
\ No newline at end of file
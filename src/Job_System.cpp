@@ -0,0 +1,165 @@
+#include "Job_System.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+
+struct Job {
+    std::function<void()> task;
+    Jobs::Counter* counter;
+};
+
+struct Job_Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+// Queue 0 belongs to threads outside the pool, queues 1..N to the workers
+static std::vector<std::unique_ptr<Job_Queue>> queues;
+static std::vector<std::thread> workers;
+static std::atomic<int> queued_jobs { 0 };
+static std::atomic<bool> running { false };
+static std::mutex sleep_mutex;
+static std::condition_variable wake;
+
+static thread_local int queue_index = 0;
+
+static bool Pop_Own(Job& job) {
+    Job_Queue& queue = *queues[queue_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+        return false;
+
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+static bool Steal(Job& job) {
+    int queue_count = queues.size();
+    for (int i = 1; i < queue_count; ++i) {
+        Job_Queue& queue = *queues[(queue_index + i) % queue_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+
+    return false;
+}
+
+static bool Run_One() {
+    Job job;
+    if (!Pop_Own(job) && !Steal(job))
+        return false;
+
+    queued_jobs--;
+    {
+        PROFILE_ZONE("job");
+        job.task();
+    }
+    job.counter->pending--;
+    return true;
+}
+
+static void Worker_Loop(int index) {
+    queue_index = index;
+    PROFILE_THREAD("worker");
+
+    while (running) {
+        if (Run_One())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [] { return queued_jobs > 0 || !running; });
+    }
+}
+
+void Jobs::Initialize(int worker_count) {
+    if (running)
+        return;
+
+    if (worker_count < 0)
+        worker_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    running = true;
+    queues.clear();
+    for (int i = 0; i < worker_count + 1; ++i) {
+        queues.push_back(std::make_unique<Job_Queue>());
+    }
+    for (int i = 1; i <= worker_count; ++i) {
+        workers.emplace_back(Worker_Loop, i);
+    }
+}
+
+void Jobs::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    queues.clear();
+    queued_jobs = 0;
+}
+
+int Jobs::Thread_Count() {
+    return workers.size() + 1;
+}
+
+void Jobs::Run(Counter& counter, std::function<void()> job) {
+    counter.pending++;
+
+    // Without workers the job runs inline
+    if (workers.empty()) {
+        job();
+        counter.pending--;
+        return;
+    }
+
+    {
+        Job_Queue& queue = *queues[queue_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({ std::move(job), &counter });
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        queued_jobs++;
+    }
+    wake.notify_one();
+}
+
+void Jobs::Wait(Counter& counter) {
+    while (counter.pending > 0) {
+        if (!Run_One())
+            std::this_thread::yield();
+    }
+}
+
+void Jobs::Parallel_For(int count, int grain, const std::function<void(int, int)>& job) {
+    if (count <= 0)
+        return;
+
+    int slice_count = std::max(1, std::min(Thread_Count(), count / std::max(1, grain)));
+    int slice_size = (count + slice_count - 1) / slice_count;
+
+    Counter counter;
+    for (int first = 0; first < count; first += slice_size) {
+        int slice = std::min(slice_size, count - first);
+        Run(counter, [&job, first, slice] { job(first, slice); });
+    }
+    Wait(counter);
+}
\ No newline at end of file
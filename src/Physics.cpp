@@ -0,0 +1,529 @@
+#include "Physics.hpp"
+
+// SSE2 is part of x86-64, so the sweep needs no runtime dispatch
+#if defined(__x86_64__) || defined(_M_X64)
+#define PHYSICS_SSE
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "Vertex_Kernel.hpp"
+#include "Profiler.hpp"
+
+using Vertex_Kernel::QUAD_VERTEX_COUNT;
+using Vertex_Kernel::VERTEX_SIZE;
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+// An insertion sort may shift this many entries per body before the order is
+// considered scrambled and sorted from scratch
+constexpr size_t MAX_SHIFTS_PER_BODY = 8;
+// Approach speeds below this do not bounce
+constexpr float RESTING_SPEED = 1.0f;
+
+uint32_t Physics::World::create_box(glm::vec2 position, glm::vec2 half_extent, float mass) {
+    positions.push_back(position);
+    velocities.push_back(glm::vec2(0.0f));
+    inverse_masses.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+    local_min.push_back(-glm::abs(half_extent));
+    local_max.push_back(glm::abs(half_extent));
+    shapes.push_back(-1);
+    resort = true;
+    return positions.size() - 1;
+}
+
+uint32_t Physics::World::create_polygon(glm::vec2 position, const glm::vec2* vertices, int vertex_count, float mass) {
+    Polygon polygon;
+    polygon.vertex_count = std::min(vertex_count, MAX_POLYGON_VERTICES);
+    glm::vec2 min(INF);
+    glm::vec2 max(-INF);
+    for (int v = 0; v < polygon.vertex_count; ++v) {
+        polygon.vertices[v] = vertices[v];
+        min = glm::min(min, vertices[v]);
+        max = glm::max(max, vertices[v]);
+    }
+
+    positions.push_back(position);
+    velocities.push_back(glm::vec2(0.0f));
+    inverse_masses.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+    local_min.push_back(min);
+    local_max.push_back(max);
+    shapes.push_back(polygons.size());
+    polygons.push_back(polygon);
+    resort = true;
+    return positions.size() - 1;
+}
+
+// Sorts keys and ids together, giving up once the shift budget runs out
+static bool Insertion_Sort(float* keys, uint32_t* ids, int count, size_t budget) {
+    size_t shifts = 0;
+    for (int k = 1; k < count; ++k) {
+        float key = keys[k];
+        uint32_t id = ids[k];
+        int j = k;
+        for (; j > 0 && keys[j - 1] > key; --j) {
+            keys[j] = keys[j - 1];
+            ids[j] = ids[j - 1];
+        }
+        keys[j] = key;
+        ids[j] = id;
+
+        shifts += k - j;
+        if (shifts > budget)
+            return false;
+    }
+    return true;
+}
+
+void Physics::World::sort_bounds() {
+    int count = size();
+    if (resort || (int) sweep_ids.size() != count) {
+        sweep_ids.resize(count);
+        for (int i = 0; i < count; ++i)
+            sweep_ids[i] = i;
+    }
+
+    // Keys in last step's order, which is nearly sorted again unless bodies
+    // were added or moved far
+    sweep_min_x.resize(count + SWEEP_PADDING);
+    for (int k = 0; k < count; ++k)
+        sweep_min_x[k] = positions[sweep_ids[k]].x + local_min[sweep_ids[k]].x;
+
+    if (resort || !Insertion_Sort(sweep_min_x.data(), sweep_ids.data(), count, count * MAX_SHIFTS_PER_BODY)) {
+        std::vector<std::pair<float, uint32_t>> order(count);
+        for (int k = 0; k < count; ++k)
+            order[k] = { sweep_min_x[k], sweep_ids[k] };
+        std::sort(order.begin(), order.end());
+        for (int k = 0; k < count; ++k) {
+            sweep_min_x[k] = order[k].first;
+            sweep_ids[k] = order[k].second;
+        }
+        resort = false;
+    }
+
+    sweep_max_x.resize(count + SWEEP_PADDING);
+    sweep_min_y.resize(count + SWEEP_PADDING);
+    sweep_max_y.resize(count + SWEEP_PADDING);
+    solver_inverse_masses.resize(count);
+    for (int k = 0; k < count; ++k) {
+        uint32_t id = sweep_ids[k];
+        sweep_max_x[k] = positions[id].x + local_max[id].x;
+        sweep_min_y[k] = positions[id].y + local_min[id].y;
+        sweep_max_y[k] = positions[id].y + local_max[id].y;
+        solver_inverse_masses[k] = inverse_masses[id];
+    }
+
+    // Sentinels start beyond every body, so no test accepts them
+    for (int k = count; k < count + SWEEP_PADDING; ++k) {
+        sweep_min_x[k] = INF;
+        sweep_max_x[k] = -INF;
+        sweep_min_y[k] = INF;
+        sweep_max_y[k] = -INF;
+    }
+}
+
+static void Add_Pair(std::vector<uint32_t>& pairs, const float* inverse_masses, uint32_t a, uint32_t b) {
+    if (inverse_masses[a] == 0.0f && inverse_masses[b] == 0.0f)
+        return;
+    pairs.push_back(a);
+    pairs.push_back(b);
+}
+
+// Every body is tested against the ones after it in sweep order until their
+// left edges pass its right edge
+static void Sweep_Scalar(const Physics::World& world, const float* inverse_masses, std::vector<uint32_t>& pairs) {
+    const float* min_x = world.sweep_min_x.data();
+    const float* max_x = world.sweep_max_x.data();
+    const float* min_y = world.sweep_min_y.data();
+    const float* max_y = world.sweep_max_y.data();
+
+    uint32_t count = world.size();
+    for (uint32_t a = 0; a < count; ++a) {
+        for (uint32_t b = a + 1; b < count && min_x[b] <= max_x[a]; ++b) {
+            if (min_y[b] <= max_y[a] && max_y[b] >= min_y[a])
+                Add_Pair(pairs, inverse_masses, a, b);
+        }
+    }
+}
+
+#ifdef PHYSICS_SSE
+// Four candidates per test. The left edges are sorted, so once one candidate
+// fails the x test every later one does too.
+static void Sweep_SSE(const Physics::World& world, const float* inverse_masses, std::vector<uint32_t>& pairs) {
+    const float* min_x = world.sweep_min_x.data();
+    const float* max_x = world.sweep_max_x.data();
+    const float* min_y = world.sweep_min_y.data();
+    const float* max_y = world.sweep_max_y.data();
+
+    uint32_t count = world.size();
+    for (uint32_t a = 0; a < count; ++a) {
+        __m128 right = _mm_set1_ps(max_x[a]);
+        __m128 bottom = _mm_set1_ps(min_y[a]);
+        __m128 top = _mm_set1_ps(max_y[a]);
+
+        for (uint32_t b = a + 1; b < count; b += 4) {
+            __m128 in_x = _mm_cmple_ps(_mm_loadu_ps(min_x + b), right);
+            int x_mask = _mm_movemask_ps(in_x);
+            if (x_mask == 0)
+                break;
+
+            __m128 in_y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_y + b), top),
+                                     _mm_cmpge_ps(_mm_loadu_ps(max_y + b), bottom));
+            int mask = _mm_movemask_ps(_mm_and_ps(in_x, in_y));
+            while (mask) {
+                int lane = 0;
+                while (!(mask & (1 << lane)))
+                    ++lane;
+                Add_Pair(pairs, inverse_masses, a, b + lane);
+                mask &= mask - 1;
+            }
+
+            if (x_mask != 0xF)
+                break;
+        }
+    }
+}
+#endif
+
+void Physics::World::find_pairs() {
+    PROFILE_ZONE("broadphase");
+
+    sort_bounds();
+
+    pairs.clear();
+#ifdef PHYSICS_SSE
+    if (use_simd) {
+        Sweep_SSE(*this, solver_inverse_masses.data(), pairs);
+        return;
+    }
+#endif
+    Sweep_Scalar(*this, solver_inverse_masses.data(), pairs);
+}
+
+// World space vertices of a body's shape, boxes from their bounds
+static int Shape_Vertices(const Physics::World& world, uint32_t id, glm::vec2* vertices) {
+    glm::vec2 position = world.positions[id];
+    int32_t shape = world.shapes[id];
+    if (shape < 0) {
+        glm::vec2 min = position + world.local_min[id];
+        glm::vec2 max = position + world.local_max[id];
+        vertices[0] = min;
+        vertices[1] = glm::vec2(max.x, min.y);
+        vertices[2] = max;
+        vertices[3] = glm::vec2(min.x, max.y);
+        return 4;
+    }
+
+    const Physics::Polygon& polygon = world.polygons[shape];
+    for (int v = 0; v < polygon.vertex_count; ++v)
+        vertices[v] = position + polygon.vertices[v];
+    return polygon.vertex_count;
+}
+
+// Smallest overlap over the edge normals of `edges`, or false when one of
+// them separates the shapes
+static bool Least_Overlap(const glm::vec2* edges, int edge_count, const glm::vec2* a, int a_count,
+                          const glm::vec2* b, int b_count, glm::vec2& normal, float& depth) {
+    for (int e = 0; e < edge_count; ++e) {
+        glm::vec2 edge = edges[(e + 1) % edge_count] - edges[e];
+        float length = std::sqrt(edge.x * edge.x + edge.y * edge.y);
+        if (length <= 0.0f)
+            continue;
+        glm::vec2 axis(edge.y / length, -edge.x / length);
+
+        float a_min = INF, a_max = -INF;
+        for (int v = 0; v < a_count; ++v) {
+            float projection = glm::dot(a[v], axis);
+            a_min = std::min(a_min, projection);
+            a_max = std::max(a_max, projection);
+        }
+        float b_min = INF, b_max = -INF;
+        for (int v = 0; v < b_count; ++v) {
+            float projection = glm::dot(b[v], axis);
+            b_min = std::min(b_min, projection);
+            b_max = std::max(b_max, projection);
+        }
+
+        float overlap = std::min(a_max, b_max) - std::max(a_min, b_min);
+        if (overlap <= 0.0f)
+            return false;
+        if (overlap < depth) {
+            depth = overlap;
+            normal = axis;
+        }
+    }
+    return true;
+}
+
+void Physics::World::find_contacts(float dt) {
+    PROFILE_ZONE("narrowphase");
+
+    int count = size();
+    solver_velocities.resize(count);
+    for (int k = 0; k < count; ++k)
+        solver_velocities[k] = velocities[sweep_ids[k]];
+    solver_separations.assign(count, glm::vec2(0.0f));
+
+    contacts.clear();
+    glm::vec2 a_vertices[MAX_POLYGON_VERTICES];
+    glm::vec2 b_vertices[MAX_POLYGON_VERTICES];
+    for (size_t p = 0; p < pairs.size(); p += 2) {
+        uint32_t a = pairs[p];
+        uint32_t b = pairs[p + 1];
+        uint32_t a_id = sweep_ids[a];
+        uint32_t b_id = sweep_ids[b];
+
+        glm::vec2 a_center((sweep_min_x[a] + sweep_max_x[a]) * 0.5f, (sweep_min_y[a] + sweep_max_y[a]) * 0.5f);
+        glm::vec2 b_center((sweep_min_x[b] + sweep_max_x[b]) * 0.5f, (sweep_min_y[b] + sweep_max_y[b]) * 0.5f);
+
+        glm::vec2 normal;
+        float depth = INF;
+        if (shapes[a_id] < 0 && shapes[b_id] < 0) {
+            // Two boxes overlap exactly where their bounds do
+            float overlap_x = std::min(sweep_max_x[a], sweep_max_x[b]) - std::max(sweep_min_x[a], sweep_min_x[b]);
+            float overlap_y = std::min(sweep_max_y[a], sweep_max_y[b]) - std::max(sweep_min_y[a], sweep_min_y[b]);
+            if (overlap_x <= 0.0f || overlap_y <= 0.0f)
+                continue;
+            if (overlap_x < overlap_y) {
+                depth = overlap_x;
+                normal = glm::vec2(1.0f, 0.0f);
+            }
+            else {
+                depth = overlap_y;
+                normal = glm::vec2(0.0f, 1.0f);
+            }
+        }
+        else {
+            int a_count = Shape_Vertices(*this, a_id, a_vertices);
+            int b_count = Shape_Vertices(*this, b_id, b_vertices);
+            if (!Least_Overlap(a_vertices, a_count, a_vertices, a_count, b_vertices, b_count, normal, depth) ||
+                !Least_Overlap(b_vertices, b_count, a_vertices, a_count, b_vertices, b_count, normal, depth))
+                continue;
+        }
+        if (glm::dot(b_center - a_center, normal) < 0.0f)
+            normal = -normal;
+
+        Contact contact;
+        contact.a = a;
+        contact.b = b;
+        contact.normal = normal;
+        contact.depth = depth;
+        contact.mass = 1.0f / (solver_inverse_masses[a] + solver_inverse_masses[b]);
+        // The overlap is corrected through the solver rather than by moving
+        // bodies directly, so whole stacks share the correction
+        float approach = glm::dot(solver_velocities[b] - solver_velocities[a], normal);
+        contact.target_velocity = approach < -RESTING_SPEED ? -restitution * approach : 0.0f;
+        contact.separation_velocity = correction / dt * std::max(depth - slop, 0.0f);
+        contact.normal_impulse = 0.0f;
+        contact.tangent_impulse = 0.0f;
+        contact.separation_impulse = 0.0f;
+        contacts.push_back(contact);
+    }
+}
+
+// Cached impulses are grouped by a dynamic body of the pair, the lower id
+// when both are. Static bodies such as the ground may touch any number of
+// others, but a dynamic one only touches its neighbours, so groups stay small.
+static void Cache_Key(const Physics::World& world, uint32_t a_id, uint32_t b_id, uint32_t& owner, uint32_t& other) {
+    bool a_static = world.inverse_masses[a_id] == 0.0f;
+    bool b_static = world.inverse_masses[b_id] == 0.0f;
+    if (a_static != b_static ? b_static : a_id < b_id) {
+        owner = a_id;
+        other = b_id;
+    }
+    else {
+        owner = b_id;
+        other = a_id;
+    }
+}
+
+// Applies last step's impulses of contacts that still exist, so resting
+// stacks start the solver close to their solution
+void Physics::World::warm_start() {
+    uint32_t cached_bodies = cache_offsets.empty() ? 0 : cache_offsets.size() - 1;
+    for (Contact& contact : contacts) {
+        uint32_t owner, other;
+        Cache_Key(*this, sweep_ids[contact.a], sweep_ids[contact.b], owner, other);
+        if (owner >= cached_bodies)
+            continue;
+
+        for (uint32_t c = cache_offsets[owner]; c < cache_offsets[owner + 1]; ++c) {
+            if (cache[c].other != other)
+                continue;
+            contact.normal_impulse = cache[c].normal_impulse;
+            contact.tangent_impulse = cache[c].tangent_impulse;
+
+            glm::vec2 tangent(-contact.normal.y, contact.normal.x);
+            glm::vec2 impulse = contact.normal * contact.normal_impulse + tangent * contact.tangent_impulse;
+            solver_velocities[contact.a] -= impulse * solver_inverse_masses[contact.a];
+            solver_velocities[contact.b] += impulse * solver_inverse_masses[contact.b];
+            break;
+        }
+    }
+}
+
+void Physics::World::solve_contacts() {
+    PROFILE_ZONE("solver");
+
+    glm::vec2* velocity = solver_velocities.data();
+    glm::vec2* separation = solver_separations.data();
+    const float* inverse_mass = solver_inverse_masses.data();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        for (Contact& contact : contacts) {
+            glm::vec2& a_velocity = velocity[contact.a];
+            glm::vec2& b_velocity = velocity[contact.b];
+            float a_inverse_mass = inverse_mass[contact.a];
+            float b_inverse_mass = inverse_mass[contact.b];
+
+            // Normal impulses only push, so their total stays non-negative
+            float normal_velocity = glm::dot(b_velocity - a_velocity, contact.normal);
+            float impulse = (contact.target_velocity - normal_velocity) * contact.mass;
+            float total = std::max(contact.normal_impulse + impulse, 0.0f);
+            impulse = total - contact.normal_impulse;
+            contact.normal_impulse = total;
+            a_velocity -= contact.normal * (impulse * a_inverse_mass);
+            b_velocity += contact.normal * (impulse * b_inverse_mass);
+
+            // Friction, bounded by the normal impulse
+            glm::vec2 tangent(-contact.normal.y, contact.normal.x);
+            float tangent_velocity = glm::dot(b_velocity - a_velocity, tangent);
+            float limit = friction * contact.normal_impulse;
+            float tangent_total = std::clamp(contact.tangent_impulse - tangent_velocity * contact.mass, -limit, limit);
+            float tangent_impulse = tangent_total - contact.tangent_impulse;
+            contact.tangent_impulse = tangent_total;
+            a_velocity -= tangent * (tangent_impulse * a_inverse_mass);
+            b_velocity += tangent * (tangent_impulse * b_inverse_mass);
+
+            // Overlap correction, solved the same way on its own velocities
+            float separating = glm::dot(separation[contact.b] - separation[contact.a], contact.normal);
+            float push = (contact.separation_velocity - separating) * contact.mass;
+            float push_total = std::max(contact.separation_impulse + push, 0.0f);
+            push = push_total - contact.separation_impulse;
+            contact.separation_impulse = push_total;
+            separation[contact.a] -= contact.normal * (push * a_inverse_mass);
+            separation[contact.b] += contact.normal * (push * b_inverse_mass);
+        }
+    }
+}
+
+// Groups the impulses by owner with a counting sort, see Cache_Key
+void Physics::World::store_impulses() {
+    cache_offsets.assign(size() + 1, 0);
+    cache.resize(contacts.size());
+    uint32_t owner, other;
+    for (const Contact& contact : contacts) {
+        Cache_Key(*this, sweep_ids[contact.a], sweep_ids[contact.b], owner, other);
+        cache_offsets[owner + 1]++;
+    }
+    for (size_t i = 1; i < cache_offsets.size(); ++i)
+        cache_offsets[i] += cache_offsets[i - 1];
+
+    cache_cursors.assign(cache_offsets.begin(), cache_offsets.end() - 1);
+    for (const Contact& contact : contacts) {
+        Cache_Key(*this, sweep_ids[contact.a], sweep_ids[contact.b], owner, other);
+        cache[cache_cursors[owner]++] = { other, contact.normal_impulse, contact.tangent_impulse };
+    }
+}
+
+void Physics::World::step(float dt) {
+    PROFILE_ZONE("physics");
+
+    int count = size();
+    if (count == 0)
+        return;
+
+    for (int i = 0; i < count; ++i) {
+        if (inverse_masses[i] > 0.0f)
+            velocities[i] += gravity * dt;
+    }
+
+    find_pairs();
+    find_contacts(dt);
+    warm_start();
+    solve_contacts();
+
+    for (int k = 0; k < count; ++k) {
+        uint32_t id = sweep_ids[k];
+        if (solver_inverse_masses[k] == 0.0f)
+            continue;
+        velocities[id] = solver_velocities[k];
+        positions[id] += (velocities[id] + solver_separations[k]) * dt;
+    }
+
+    store_impulses();
+}
+
+static void Write_Quad(std::vector<float>& stream, const glm::vec2* corners, uint32_t color) {
+    for (int v = 0; v < QUAD_VERTEX_COUNT; ++v) {
+        float vertex[VERTEX_SIZE] = { corners[v].x, corners[v].y };
+        std::memcpy(&vertex[2], &color, sizeof(color));
+        stream.insert(stream.end(), vertex, vertex + VERTEX_SIZE);
+    }
+}
+
+void Physics::World::build_debug_shapes(Renderer::Sprite_Batch& batch) const {
+    batch.clear();
+
+    const uint32_t static_color = Vertex_Kernel::Pack_Color(glm::vec3(0.35f));
+    const uint32_t dynamic_color = Vertex_Kernel::Pack_Color(glm::vec3(0.1f, 0.7f, 0.3f));
+
+    glm::vec2 vertices[MAX_POLYGON_VERTICES];
+    for (int id = 0; id < size(); ++id) {
+        uint32_t color = inverse_masses[id] == 0.0f ? static_color : dynamic_color;
+        int count = Shape_Vertices(*this, id, vertices);
+
+        // Convex polygons split into quads fanning from the first vertex; the
+        // last one repeats a vertex when the triangle count is odd
+        for (int v = 1; v + 1 < count; v += 2) {
+            glm::vec2 corners[QUAD_VERTEX_COUNT] = { vertices[0], vertices[v], vertices[v + 1], vertices[std::min(v + 2, count - 1)] };
+            Write_Quad(batch.buffer.stream, corners, color);
+            batch.sprite_count++;
+        }
+    }
+}
+
+void Sync_Solids(const Physics::World& world, Entity_Store& entities, const std::vector<Solid>& solids) {
+    for (const Solid& solid : solids) {
+        if (!entities.is_alive(solid.entity))
+            continue;
+
+        uint32_t index = entities.index_of(solid.entity);
+        glm::vec3 position = entities.position(index);
+        glm::vec2 body_position = world.positions[solid.body];
+        // Resting bodies leave their entities unchanged, so nothing is rebuilt
+        if (position.x == body_position.x && position.y == body_position.y)
+            continue;
+        entities.set_transform(solid.entity, glm::vec3(body_position, position.z), entities.scale(index));
+    }
+}
+
+void Save_Solids(Asset_Pack::Pack_Writer& writer, const std::string& name, const Physics::World& world,
+                 const Entity_Store& entities, const std::vector<Solid>& solids) {
+    std::vector<float> masses(entities.size(), Asset_Pack::NO_BODY);
+    for (const Solid& solid : solids) {
+        if (!entities.is_alive(solid.entity))
+            continue;
+
+        float inverse_mass = world.inverse_masses[solid.body];
+        masses[entities.index_of(solid.entity)] = inverse_mass > 0.0f ? 1.0f / inverse_mass : 0.0f;
+    }
+    Asset_Pack::Add_Bodies(writer, name, masses.size(), masses.data());
+}
+
+void Load_Solids(const Asset_Pack::Bodies_View& bodies, uint32_t first, Physics::World& world,
+                 const Entity_Store& entities, std::vector<Solid>& solids) {
+    for (uint32_t e = 0; e < bodies.entity_count && first + e < (uint32_t) entities.size(); ++e) {
+        float mass = bodies.masses[e];
+        if (!(mass >= 0.0f))
+            continue;
+
+        glm::vec3 position = entities.position(first + e);
+        glm::vec3 scale = entities.scale(first + e);
+        glm::vec2 half_extent(scale.x * 0.5f, scale.y * 0.5f);
+        uint32_t body = world.create_box(glm::vec2(position.x, position.y), half_extent, mass);
+        solids.push_back({ entities.handle_of(first + e), body });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Vertex_Kernel.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// Written only by its own thread. The head is published after the event, so a
+// reader sees whole events up to the head it loaded.
+struct Thread_Buffer {
+    Event events[Profiler::EVENT_CAPACITY];
+    std::atomic<uint64_t> head { 0 };
+    int id = 0;
+    char name[32] = {};
+};
+
+static const Clock::time_point epoch = Clock::now();
+
+static std::atomic<Thread_Buffer*> thread_buffers[Profiler::MAX_THREADS];
+static std::atomic<int> thread_count { 0 };
+static thread_local Thread_Buffer* local_buffer = nullptr;
+static thread_local bool local_registered = false;
+
+// Each thread claims a slot the first time it records
+static Thread_Buffer* Register_Buffer(const char* name) {
+    int index = thread_count.fetch_add(1);
+    if (index >= Profiler::MAX_THREADS)
+        return nullptr;
+
+    Thread_Buffer* buffer = new Thread_Buffer();
+    buffer->id = index;
+    snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    thread_buffers[index].store(buffer, std::memory_order_release);
+    return buffer;
+}
+
+static Thread_Buffer* Local_Buffer() {
+    if (!local_registered) {
+        local_registered = true;
+        char name[32];
+        snprintf(name, sizeof(name), "thread %d", thread_count.load());
+        local_buffer = Register_Buffer(name);
+    }
+    return local_buffer;
+}
+
+static void Record_To(Thread_Buffer* buffer, const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if (!buffer)
+        return;
+
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head % Profiler::EVENT_CAPACITY] = { name, start_ns, end_ns };
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::Now_Ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+void Profiler::Record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    Record_To(Local_Buffer(), name, start_ns, end_ns);
+}
+
+void Profiler::Set_Thread_Name(const char* name) {
+    Thread_Buffer* buffer = Local_Buffer();
+    if (buffer)
+        snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+}
+
+Profiler::Zone::Zone(const char* name) : name(name), start_ns(Now_Ns()) {
+}
+
+Profiler::Zone::~Zone() {
+    Record(name, start_ns, Now_Ns());
+}
+
+// ================================
+// GPU timing
+// ================================
+// Timestamp queries of one frame. Two sets alternate, so a set is read back
+// two frames after it was issued.
+struct Gpu_Frame {
+    GLuint queries[Profiler::MAX_GPU_ZONES * 2];
+    const char* names[Profiler::MAX_GPU_ZONES];
+    int zone_count = 0;
+    // Frame graph entry the results belong to
+    int graph_slot = -1;
+};
+
+static Gpu_Frame gpu_frames[2];
+static int gpu_set = 0;
+static bool gpu_initialized = false;
+// GPU timestamps plus this offset are on the CPU clock
+static int64_t gpu_offset_ns = 0;
+static Thread_Buffer* gpu_buffer = nullptr;
+
+Profiler::Frame_Times Profiler::frame_times;
+static uint64_t frame_start_ns = 0;
+
+Profiler::Gpu_Zone::Gpu_Zone(const char* name) : index(-1) {
+    Gpu_Frame& frame = gpu_frames[gpu_set];
+    if (!gpu_initialized || frame.zone_count == MAX_GPU_ZONES)
+        return;
+
+    index = frame.zone_count++;
+    frame.names[index] = name;
+    glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+}
+
+Profiler::Gpu_Zone::~Gpu_Zone() {
+    if (index >= 0)
+        glQueryCounter(gpu_frames[gpu_set].queries[index * 2 + 1], GL_TIMESTAMP);
+}
+
+static void Collect_Gpu_Frame(Gpu_Frame& frame) {
+    if (frame.zone_count == 0)
+        return;
+
+    // Queries finish in order, so the last one being ready means all are
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.zone_count * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        Profiler::frame_times.gpu_dropped++;
+        frame.zone_count = 0;
+        return;
+    }
+
+    uint64_t frame_begin = UINT64_MAX;
+    uint64_t frame_end = 0;
+    for (int i = 0; i < frame.zone_count; ++i) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        Record_To(gpu_buffer, frame.names[i], begin + gpu_offset_ns, end + gpu_offset_ns);
+
+        frame_begin = std::min<uint64_t>(frame_begin, begin);
+        frame_end = std::max<uint64_t>(frame_end, end);
+    }
+
+    if (frame.graph_slot >= 0)
+        Profiler::frame_times.gpu_ms[frame.graph_slot] = (frame_end - frame_begin) / 1.0e6f;
+    frame.zone_count = 0;
+}
+
+// ================================
+// Frame graph
+// ================================
+static Renderer::Shader_Handle graph_shader;
+static Renderer::Sprite_Batch graph_batch;
+static bool graph_initialized = false;
+
+static const glm::vec2 GRAPH_ORIGIN = { 10.0f, 10.0f };
+static const float GRAPH_BAR_WIDTH = 2.0f;
+static const float GRAPH_HEIGHT = 100.0f;
+// Frame time at the top of the graph
+static const float GRAPH_MAX_MS = 1000.0f / 30.0f;
+static const float TARGET_MS = 1000.0f / 60.0f;
+
+void Profiler::Initialize(Renderer::Shader_Handle shader) {
+    for (Gpu_Frame& frame : gpu_frames)
+        glGenQueries(MAX_GPU_ZONES * 2, frame.queries);
+
+    GLint64 gpu_now = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+    gpu_offset_ns = (int64_t) Now_Ns() - gpu_now;
+    gpu_buffer = Register_Buffer("GPU");
+    gpu_initialized = true;
+
+    graph_shader = shader;
+    Renderer::Initialize_Batch("profiler_graph", shader, graph_batch, GRAPH_FRAMES * 2 + 2);
+    graph_initialized = true;
+}
+
+void Profiler::Begin_Frame() {
+    frame_start_ns = Now_Ns();
+
+    gpu_set ^= 1;
+    if (gpu_initialized)
+        Collect_Gpu_Frame(gpu_frames[gpu_set]);
+}
+
+void Profiler::End_Frame() {
+    uint64_t end_ns = Now_Ns();
+    Record("frame", frame_start_ns, end_ns);
+
+    int slot = frame_times.next;
+    frame_times.cpu_ms[slot] = (end_ns - frame_start_ns) / 1.0e6f;
+    frame_times.gpu_ms[slot] = 0.0f;
+    gpu_frames[gpu_set].graph_slot = slot;
+    frame_times.next = (slot + 1) % GRAPH_FRAMES;
+}
+
+void Profiler::Submit_Graph(Renderer::Render_Queue& queue) {
+    if (!graph_initialized)
+        return;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::vec3> tints;
+    auto add_rect = [&](glm::vec2 min, glm::vec2 size, glm::vec3 tint) {
+        positions.push_back(glm::vec3(min.x + size.x * 0.5f, min.y + size.y * 0.5f, 0.0f));
+        scales.push_back(glm::vec3(size.x, size.y, 1.0f));
+        tints.push_back(tint);
+    };
+
+    float width = GRAPH_FRAMES * GRAPH_BAR_WIDTH;
+    float ms_to_pixels = GRAPH_HEIGHT / GRAPH_MAX_MS;
+    add_rect(GRAPH_ORIGIN, glm::vec2(width, GRAPH_HEIGHT), glm::vec3(0.1f));
+
+    for (int i = 0; i < GRAPH_FRAMES; ++i) {
+        int slot = (frame_times.next + i) % GRAPH_FRAMES;
+        float x = GRAPH_ORIGIN.x + i * GRAPH_BAR_WIDTH;
+
+        float cpu_ms = frame_times.cpu_ms[slot];
+        if (cpu_ms > 0.0f) {
+            glm::vec3 tint = cpu_ms <= TARGET_MS ? glm::vec3(0.3f, 0.8f, 0.3f)
+                           : cpu_ms <= GRAPH_MAX_MS ? glm::vec3(0.9f, 0.8f, 0.2f)
+                           : glm::vec3(0.9f, 0.25f, 0.2f);
+            add_rect(glm::vec2(x, GRAPH_ORIGIN.y), glm::vec2(GRAPH_BAR_WIDTH, std::min(cpu_ms * ms_to_pixels, GRAPH_HEIGHT)), tint);
+        }
+
+        float gpu_ms = frame_times.gpu_ms[slot];
+        if (gpu_ms > 0.0f)
+            add_rect(glm::vec2(x, GRAPH_ORIGIN.y), glm::vec2(GRAPH_BAR_WIDTH * 0.5f, std::min(gpu_ms * ms_to_pixels, GRAPH_HEIGHT)), glm::vec3(0.3f, 0.5f, 1.0f));
+    }
+
+    add_rect(glm::vec2(GRAPH_ORIGIN.x, GRAPH_ORIGIN.y + TARGET_MS * ms_to_pixels), glm::vec2(width, 1.0f), glm::vec3(0.9f));
+
+    int count = positions.size();
+    graph_batch.buffer.stream.resize(count * Vertex_Kernel::QUAD_SIZE);
+    Vertex_Kernel::Transform_Quads(positions.data(), scales.data(), tints.data(), count, graph_batch.buffer.stream.data());
+    graph_batch.sprite_count = count;
+    graph_batch.unchanged = false;
+
+    Renderer::Submit_Batch(queue, graph_shader, graph_batch, UINT16_MAX);
+}
+
+// ================================
+// Trace export
+// ================================
+bool Profiler::Write_Trace(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Failed to write trace %s\n", path.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"OpenGL\"}}");
+
+    std::vector<Event> events;
+    int buffer_count = std::min(thread_count.load(), MAX_THREADS);
+    for (int t = 0; t < buffer_count; ++t) {
+        Thread_Buffer* buffer = thread_buffers[t].load(std::memory_order_acquire);
+        if (!buffer)
+            continue;
+
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+            buffer->id, buffer->name);
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > EVENT_CAPACITY ? head - EVENT_CAPACITY : 0;
+        events.clear();
+        for (uint64_t e = first; e < head; ++e)
+            events.push_back(buffer->events[e % EVENT_CAPACITY]);
+
+        // Slots the thread wrapped around to while copying hold newer events
+        uint64_t after = buffer->head.load(std::memory_order_acquire);
+        uint64_t valid = after > EVENT_CAPACITY ? after - EVENT_CAPACITY : 0;
+        for (uint64_t e = std::max(first, valid); e < head; ++e) {
+            const Event& event = events[e - first];
+            fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                event.name, buffer->id, event.start_ns / 1000.0, (event.end_ns - event.start_ns) / 1000.0);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "Render_Queue.hpp"
+
+#include "Profiler.hpp"
+
+// Key layout, most significant first:
+// layer (16 bits) | shader (12 bits) | texture (16 bits) | VAO (20 bits)
+static uint64_t Make_Key(uint16_t layer, Renderer::Shader_Handle shader, GLuint texture, Renderer::VAO_Handle vao) {
+    return ((uint64_t) layer << 48)
+         | ((uint64_t) (shader.id & 0xFFF) << 36)
+         | ((uint64_t) (texture & 0xFFFF) << 20)
+         | ((uint64_t) (vao.id & 0xFFFFF));
+}
+
+// Stable LSD radix sort, one byte per pass. Passes where every key has the
+// same byte are skipped, which is most of them when few states are in use.
+static void Radix_Sort(std::vector<Renderer::Draw_Command>& commands, std::vector<Renderer::Draw_Command>& scratch) {
+    scratch.resize(commands.size());
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const Renderer::Draw_Command& command : commands) {
+            counts[(command.key >> shift) & 0xFF]++;
+        }
+        if (counts[(commands[0].key >> shift) & 0xFF] == commands.size())
+            continue;
+
+        size_t offsets[256];
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            offsets[b] = offset;
+            offset += counts[b];
+        }
+
+        for (const Renderer::Draw_Command& command : commands) {
+            scratch[offsets[(command.key >> shift) & 0xFF]++] = command;
+        }
+        commands.swap(scratch);
+    }
+}
+
+void Renderer::Render_Queue::clear() {
+    for (const Draw_Command& command : commands) {
+        if (command.ring)
+            command.ring->queued_draws--;
+    }
+    commands.clear();
+}
+
+void Renderer::Submit(Render_Queue& queue, Shader_Handle shader, VAO_Handle vao, Vertex_Buffer& buffer, uint16_t layer, GLuint texture) {
+    Draw_Command command {};
+    command.key = Make_Key(layer, shader, texture, vao);
+    command.shader = shader;
+    command.vao = vao;
+    command.texture = texture;
+    command.primitive = buffer.primitive;
+    command.indexed = buffer.indexed;
+    command.ring = buffer.ring;
+
+    if (buffer.ring) {
+        buffer.ring->queued_draws++;
+        command.segment = buffer.ring->segment;
+        command.first = buffer.ring->first_vertex;
+        command.count = buffer.ring->vertex_count;
+    }
+    else {
+        command.first = 0;
+        command.count = buffer.stream.size() / buffer.get_size();
+    }
+
+    queue.commands.push_back(command);
+}
+
+void Renderer::Submit_Vertices(Render_Queue& queue, Shader_Handle shader, VAO_Handle vao, const Vertex_Buffer& buffer, int first, int count, uint16_t layer, GLuint texture) {
+    Draw_Command command {};
+    command.key = Make_Key(layer, shader, texture, vao);
+    command.shader = shader;
+    command.vao = vao;
+    command.texture = texture;
+    command.primitive = buffer.primitive;
+    command.indexed = buffer.indexed;
+    command.first = first;
+    command.count = count;
+
+    queue.commands.push_back(command);
+}
+
+void Renderer::Submit_Batch(Render_Queue& queue, Shader_Handle shader, Sprite_Batch& batch, uint16_t layer, GLuint texture) {
+    if (batch.sprite_count == 0)
+        return;
+
+    if (!batch.unchanged) {
+        Update_VAO_Buffer(batch.vao, batch.buffer);
+        glBindVertexArray(0);
+    }
+
+    Submit(queue, shader, batch.vao, batch.buffer, layer, texture);
+}
+
+void Renderer::Submit_Resident(Render_Queue& queue, Shader_Handle shader, Resident_Batch& batch, uint16_t layer, GLuint texture) {
+    if (batch.sprite_count == 0)
+        return;
+
+    Upload_Resident(batch);
+
+    Draw_Command command {};
+    command.key = Make_Key(layer, shader, texture, batch.vao);
+    command.shader = shader;
+    command.vao = batch.vao;
+    command.texture = texture;
+    command.primitive = batch.buffer.primitive;
+    command.indexed = batch.buffer.indexed;
+    command.first = 0;
+    command.count = batch.sprite_count * Vertex_Kernel::QUAD_VERTEX_COUNT;
+
+    queue.commands.push_back(command);
+}
+
+void Renderer::Submit_Instanced(Render_Queue& queue, Shader_Handle shader, Instance_Batch& batch, uint16_t layer, GLuint texture) {
+    if (batch.instances.empty())
+        return;
+
+    Upload_Instances(batch);
+
+    Draw_Command command {};
+    command.key = Make_Key(layer, shader, texture, batch.vao);
+    command.shader = shader;
+    command.vao = batch.vao;
+    command.texture = texture;
+    command.primitive = GL_TRIANGLES;
+    command.first = 0;
+    command.count = batch.vertex_count;
+    command.instance_count = batch.instances.size();
+
+    queue.commands.push_back(command);
+}
+
+void Renderer::Sort_Queue(Render_Queue& queue) {
+    queue.sorted = queue.commands;
+    if (!queue.sorted.empty())
+        Radix_Sort(queue.sorted, queue.commands);
+}
+
+void Renderer::Flush_Queue(Render_Queue& queue) {
+    PROFILE_ZONE("draw");
+    PROFILE_GPU_ZONE("draw");
+
+    if (queue.commands.empty())
+        return;
+
+    Sort_Queue(queue);
+
+    // Nothing is assumed bound when the queue starts
+    const uint32_t UNBOUND = UINT32_MAX;
+    uint32_t current_shader = UNBOUND;
+    uint32_t current_vao = UNBOUND;
+    GLuint current_texture = UNBOUND;
+
+    for (Draw_Command& command : queue.sorted) {
+        if (command.shader.id != current_shader) {
+            current_shader = command.shader.id;
+            glUseProgram(Get_Shader(command.shader));
+            frame_stats.program_switches++;
+        }
+        if (command.vao.id != current_vao) {
+            current_vao = command.vao.id;
+            glBindVertexArray(Get_VAO(command.vao));
+            frame_stats.vao_binds++;
+        }
+        if (command.texture != current_texture) {
+            current_texture = command.texture;
+            glBindTexture(GL_TEXTURE_2D, command.texture);
+            frame_stats.texture_binds++;
+        }
+
+        if (command.instance_count > 0)
+            glDrawArraysInstanced(command.primitive, command.first, command.count, command.instance_count);
+        else
+            Draw_Vertices(command.primitive, command.indexed, command.first, command.count);
+        frame_stats.draw_calls++;
+
+        if (command.ring) {
+            Fence_Stream(*command.ring, command.segment);
+            command.ring->queued_draws--;
+        }
+    }
+    frame_stats.commands += queue.sorted.size();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // Sorting left the commands as scratch, and every one is drawn
+    queue.commands.clear();
+}
\ No newline at end of file
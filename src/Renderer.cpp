@@ -1,79 +1,344 @@
 #include "Renderer.hpp"
 
 #include <map>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
 #include <fstream>
+#include <sstream>
+
+#include "Asset_Pack.hpp"
+#include "Profiler.hpp"
 
 namespace Renderer {
-    std::map<std::string, GLuint> shader_map;
-    std::map<std::string, GLuint> vao_map;
+    std::vector<GLuint> shaders;
+    std::vector<uint8_t> shader_pending;
+    std::vector<GLuint> vaos;
+    std::map<std::string, Shader_Handle> shader_map;
+    std::map<std::string, VAO_Handle> vao_map;
+    Frame_Stats frame_stats;
+    Shader_Stats shader_stats;
+}
+
+Renderer::Shader_Handle Renderer::Find_Shader(const std::string& name) {
+    auto found = shader_map.find(name);
+    return found != shader_map.end() ? found->second : Shader_Handle {};
+}
+
+Renderer::VAO_Handle Renderer::Find_VAO(const std::string& name) {
+    auto found = vao_map.find(name);
+    return found != vao_map.end() ? found->second : VAO_Handle {};
+}
+
+static Renderer::VAO_Handle Register_VAO(std::string& vao_name, GLuint vao) {
+    Renderer::VAO_Handle handle { (uint32_t) Renderer::vaos.size() };
+    Renderer::vaos.push_back(vao);
+    Renderer::vao_map[vao_name] = handle;
+    return handle;
 }
 
 void ReadShaderFromFile(std::string& source, std::string file) {
-    source.clear();
+    std::ifstream filestream(file, std::ios::binary);
 
-    std::ifstream filestream {};
-    filestream.open(file);
+    std::ostringstream contents;
+    contents << filestream.rdbuf();
+    source = contents.str();
+}
 
-    std::string line {};
-    while (std::getline(filestream, line)) {
-        source.append(line + "\n");
+// Compile and link state of a shader between Create_Shader and its first use
+struct Pending_Shader {
+    std::string vertex_source;
+    std::string fragment_source;
+    GLuint vertex_shader = 0;
+    GLuint fragment_shader = 0;
+    uint64_t cache_key = 0;
+    bool from_cache = false;
+};
+
+static std::vector<Pending_Shader> pending_shaders;
+
+using Vertex_Kernel::QUAD_SIZE;
+using Vertex_Kernel::QUAD_VERTEX_COUNT;
+
+using Shader_Clock = std::chrono::steady_clock;
+
+static double Elapsed_Ms(Shader_Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Shader_Clock::now() - start).count();
+}
+
+// FNV-1a
+static uint64_t Hash(uint64_t hash, const std::string& data) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
     }
+    // Separator so ("ab", "c") and ("a", "bc") differ
+    hash ^= 0xFF;
+    hash *= 0x100000001B3ull;
+    return hash;
+}
 
-    filestream.close();
+// Program binaries are only valid for the driver that produced them, so the
+// driver strings are part of the key
+static uint64_t Cache_Key(const std::string& vertex_source, const std::string& fragment_source) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = Hash(hash, vertex_source);
+    hash = Hash(hash, fragment_source);
+    hash = Hash(hash, (const char*) glGetString(GL_VENDOR));
+    hash = Hash(hash, (const char*) glGetString(GL_RENDERER));
+    hash = Hash(hash, (const char*) glGetString(GL_VERSION));
+    return hash;
 }
 
-void Renderer::Create_Shader(std::string filename) {
-    std::string vertex_source {};
-    std::string fragment_source {};
+static std::string Cache_Path(uint64_t cache_key) {
+    char filename[32];
+    snprintf(filename, sizeof(filename), "%016llx.bin", (unsigned long long) cache_key);
+    return Renderer::SHADER_CACHE_DIRECTORY + std::string("/") + filename;
+}
+
+static bool Has_Binary_Formats() {
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    return format_count > 0;
+}
+
+// Cache file layout: binary format (GLenum) followed by the program binary
+static bool Load_Program_Binary(GLuint program, uint64_t cache_key) {
+    if (!Has_Binary_Formats())
+        return false;
+
+    std::ifstream file(Cache_Path(cache_key), std::ios::binary);
+    if (!file)
+        return false;
+
+    GLenum format = 0;
+    if (!file.read((char*) &format, sizeof(format)))
+        return false;
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty())
+        return false;
+
+    glProgramBinary(program, format, binary.data(), binary.size());
+    return true;
+}
+
+static void Save_Program_Binary(GLuint program, uint64_t cache_key) {
+    if (!Has_Binary_Formats())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(Renderer::SHADER_CACHE_DIRECTORY, error);
+
+    std::ofstream file(Cache_Path(cache_key), std::ios::binary);
+    file.write((const char*) &format, sizeof(format));
+    file.write(binary.data(), binary.size());
+}
 
-    ReadShaderFromFile(vertex_source, "assets/" + filename + ".vert");
-    ReadShaderFromFile(fragment_source, "assets/" + filename + ".frag");
+// Queues compilation and linking without querying any status, so the driver
+// can work on it in the background
+static void Compile_Program(GLuint program, Pending_Shader& pending) {
+    const GLchar* vertex_string = pending.vertex_source.c_str();
+    const GLchar* fragment_string = pending.fragment_source.c_str();
 
-    const GLchar* vertex_string = vertex_source.c_str();
-    const GLchar* fragment_string = fragment_source.c_str();
+    pending.vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pending.vertex_shader, 1, &vertex_string, NULL);
+    glCompileShader(pending.vertex_shader);
+
+    pending.fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pending.fragment_shader, 1, &fragment_string, NULL);
+    glCompileShader(pending.fragment_shader);
+
+    glAttachShader(program, pending.vertex_shader);
+    glAttachShader(program, pending.fragment_shader);
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+}
+
+static const Asset_Pack::Pack* mounted_pack = nullptr;
+
+void Renderer::Mount_Pack(const Asset_Pack::Pack* pack) {
+    mounted_pack = pack;
+}
+
+static void Read_Shader_Source(std::string& source, const std::string& file) {
+    if (mounted_pack && Asset_Pack::Get_Shader_Source(*mounted_pack, file, source))
+        return;
+    ReadShaderFromFile(source, "assets/" + file);
+}
+
+Renderer::Shader_Handle Renderer::Create_Shader(std::string filename) {
+    return Create_Shader(filename, filename, filename);
+}
+
+Renderer::Shader_Handle Renderer::Create_Shader(std::string name, std::string vertex_file, std::string fragment_file) {
+    Shader_Clock::time_point start = Shader_Clock::now();
+
+    Pending_Shader pending {};
+    Read_Shader_Source(pending.vertex_source, vertex_file + ".vert");
+    Read_Shader_Source(pending.fragment_source, fragment_file + ".frag");
+    pending.cache_key = Cache_Key(pending.vertex_source, pending.fragment_source);
+
+    GLuint program = glCreateProgram();
+    pending.from_cache = Load_Program_Binary(program, pending.cache_key);
+    if (!pending.from_cache)
+        Compile_Program(program, pending);
+
+    Shader_Handle handle { (uint32_t) shaders.size() };
+    shaders.push_back(program);
+    shader_pending.push_back(1);
+    pending_shaders.push_back(std::move(pending));
+    shader_map[name] = handle;
+
+    shader_stats.startup_ms += Elapsed_Ms(start);
+
+    return handle;
+}
+
+bool Renderer::Shader_Ready(Shader_Handle shader) {
+    if (!shader_pending[shader.id])
+        return true;
+    if (!extensions.parallel_shader_compile)
+        return true;
+
+    GLint complete = GL_FALSE;
+    glGetProgramiv(shaders[shader.id], GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+void Renderer::Resolve_Shader(Shader_Handle shader) {
+    Shader_Clock::time_point start = Shader_Clock::now();
+
+    Pending_Shader& pending = pending_shaders[shader.id];
+    GLuint program = shaders[shader.id];
 
     int success;
     char infoLog[512];
 
-    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &vertex_string, NULL);
-    glCompileShader(vertex_shader);
-    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertex_shader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success && pending.from_cache) {
+        // The cached binary was rejected, e.g. after a driver update
+        pending.from_cache = false;
+        Compile_Program(program, pending);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
     }
 
-    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 1, &fragment_string, NULL);
-    glCompileShader(fragment_shader);
-    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragment_shader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    if (pending.from_cache) {
+        shader_stats.cache_hits++;
     }
+    else {
+        shader_stats.compiled++;
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-    glLinkProgram(program);
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glGetShaderiv(pending.vertex_shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(pending.vertex_shader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+
+        glGetShaderiv(pending.fragment_shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(pending.fragment_shader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        else {
+            Save_Program_Binary(program, pending.cache_key);
+        }
+
+        glDeleteShader(pending.vertex_shader);
+        glDeleteShader(pending.fragment_shader);
+    }
+
+    pending = Pending_Shader {};
+    shader_pending[shader.id] = 0;
+
+    shader_stats.startup_ms += Elapsed_Ms(start);
+}
+
+void Renderer::Wait_Shaders() {
+    for (uint32_t id = 0; id < shaders.size(); ++id) {
+        if (shader_pending[id])
+            Resolve_Shader({ id });
+    }
+}
+
+// Points the attributes used by the shader at the bound buffer. Attributes
+// the shader does not use are skipped but still take their place in the vertex.
+// Expects the VAO and GL_ARRAY_BUFFER to be bound.
+static void Set_Attributes(GLuint shader, Vertex_Buffer& buffer_format) {
+    const Vertex_Format& format = buffer_format.format;
+
+    for (int i = 0; i < format.attribute_count; ++i) {
+        const Vertex_Attribute& attribute = format.attributes[i];
+        GLint location = glGetAttribLocation(shader, attribute.name);
+        if (location < 0)
+            continue;
+
+        glVertexAttribPointer(  location, attribute.components,
+                                attribute.type, attribute.normalized,
+                                format.stride(),
+                                (void*) (size_t) format.offset(i));
+        glEnableVertexAttribArray(location);
+    }
+}
+
+static GLuint quad_index_buffer = 0;
+static int quad_index_capacity = 0;
+
+void Renderer::Reserve_Quad_Indices(int quad_count) {
+    if (quad_count <= quad_index_capacity)
+        return;
+
+    quad_index_capacity = std::max({ quad_count, quad_index_capacity * 2, 1024 });
+    std::vector<uint32_t> indices(quad_index_capacity * Vertex_Kernel::QUAD_INDEX_COUNT);
+    for (int q = 0; q < quad_index_capacity; ++q) {
+        for (int i = 0; i < Vertex_Kernel::QUAD_INDEX_COUNT; ++i)
+            indices[q * Vertex_Kernel::QUAD_INDEX_COUNT + i] = q * QUAD_VERTEX_COUNT + Vertex_Kernel::QUAD_INDICES[i];
     }
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+    // The element binding belongs to whichever VAO is bound, so fill it
+    // through another target
+    if (!quad_index_buffer)
+        glGenBuffers(1, &quad_index_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, quad_index_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void Renderer::Draw_Vertices(GLenum primitive, bool indexed, int first_vertex, int vertex_count) {
+    if (!indexed) {
+        glDrawArrays(primitive, first_vertex, vertex_count);
+        return;
+    }
 
-    shader_map.emplace(filename, program);
+    int quad_count = vertex_count / QUAD_VERTEX_COUNT;
+    Reserve_Quad_Indices(quad_count);
+    glDrawElementsBaseVertex(primitive, quad_count * Vertex_Kernel::QUAD_INDEX_COUNT, GL_UNSIGNED_INT, NULL, first_vertex);
 }
 
-void Renderer::Initialize_VAO(std::string vao_handle, GLuint shader, Vertex_Buffer& buffer_format) {
+Renderer::VAO_Handle Renderer::Initialize_VAO(std::string vao_name, Shader_Handle shader, Vertex_Buffer& buffer_format) {
     GLuint vao;
     GLuint& buffer_object = buffer_format.buffer_object;
 
@@ -85,65 +350,443 @@ void Renderer::Initialize_VAO(std::string vao_handle, GLuint shader, Vertex_Buff
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, buffer_object);
 
-    // Get the locations of attributes used in this shader
-    GLint position_location = glGetAttribLocation(shader, "in_position");
-    GLint color_location = glGetAttribLocation(shader, "in_color");
-    GLint texcoord_location = glGetAttribLocation(shader, "in_texcoord");
+    Set_Attributes(Get_Shader(shader), buffer_format);
 
-    size_t offset = 0;
-    if (position_location >= 0) {
-        glVertexAttribPointer(  position_location, buffer_format.position_size,
-                                GL_FLOAT, GL_FALSE,
-                                buffer_format.get_size() * sizeof(float),
-                                (void*) offset);
-        glEnableVertexAttribArray(position_location);
-        offset += buffer_format.position_size;
+    if (buffer_format.indexed) {
+        Reserve_Quad_Indices(1);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_index_buffer);
     }
-    if (color_location >= 0) {
-        glVertexAttribPointer(  color_location, buffer_format.color_size,
-                                GL_FLOAT, GL_FALSE,
-                                 buffer_format.get_size() * sizeof(float),
-                                 (void*) offset);
-        glEnableVertexAttribArray(color_location);
-        offset += buffer_format.color_size;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return Register_VAO(vao_name, vao);
+}
+
+void Renderer::Update_VAO_Buffer(VAO_Handle vao, Vertex_Buffer& buffer) {
+    PROFILE_ZONE("upload");
+    glBindVertexArray(Get_VAO(vao));
+
+    // Batches built in place through Map_Batch never get here; this copy is
+    // for the ones built into buffer.stream
+    if (buffer.ring) {
+        float* destination = Map_Stream(buffer, buffer.stream.size());
+        if (destination)
+            std::memcpy(destination, buffer.stream.data(), buffer.stream.size() * sizeof(float));
+        Unmap_Stream(buffer);
+        glBindVertexArray(0);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
+    glBufferData(GL_ARRAY_BUFFER, buffer.stream.size() * sizeof(float), buffer.stream.data(), GL_DYNAMIC_DRAW);
+    frame_stats.bytes_uploaded += buffer.stream.size() * sizeof(float);
+    frame_stats.buffer_updates++;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Blocks until the GPU is done with a segment. Only counted as a wait when the
+// fence had not already signaled.
+static void Wait_Fence(GLsync& fence) {
+    if (!fence)
+        return;
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        Renderer::frame_stats.fence_waits++;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+static void Allocate_Stream(Vertex_Buffer& buffer, size_t segment_size) {
+    Renderer::Stream_Ring& ring = *buffer.ring;
+
+    // Keep segments a whole number of vertices so each starts on a vertex
+    size_t stride = buffer.get_size() * sizeof(float);
+    ring.segment_size = (segment_size + stride - 1) / stride * stride;
+    size_t total_size = ring.segment_size * Renderer::Stream_Ring::SEGMENT_COUNT;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
+
+    ring.mapped = nullptr;
+    ring.persistent = false;
+    if (Renderer::extensions.buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        Renderer::gl_buffer_storage(GL_ARRAY_BUFFER, total_size, NULL, flags);
+        ring.mapped = (char*) glMapBufferRange(GL_ARRAY_BUFFER, 0, total_size, flags);
+        ring.persistent = ring.mapped != nullptr;
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, total_size, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Buffer storage is immutable, so growing the ring replaces the buffer object
+// and points the VAO at the new one. Draws already issued keep reading the old
+// buffer, which GL frees once they finish, so its fences are dropped. Queued
+// draws would read the new one instead, so there must be none.
+static void Resize_Stream(Vertex_Buffer& buffer, size_t segment_size) {
+    Renderer::Stream_Ring& ring = *buffer.ring;
+    assert(ring.queued_draws == 0);
+
+    for (GLsync& fence : ring.fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
     }
-    if  (texcoord_location >= 0) {
-        glVertexAttribPointer(  texcoord_location, buffer_format.texcoord_size,
-                                GL_FLOAT, GL_FALSE,
-                                buffer_format.get_size() * sizeof(float),
-                                (void*) offset);
-        glEnableVertexAttribArray(texcoord_location);
-        offset += buffer_format.texcoord_size;
+
+    if (ring.persistent) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
     }
+    glDeleteBuffers(1, &buffer.buffer_object);
+    glGenBuffers(1, &buffer.buffer_object);
 
+    glBindVertexArray(ring.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
+    Set_Attributes(ring.shader, buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    vao_map.emplace(vao_handle, vao);
+    Allocate_Stream(buffer, segment_size);
+}
+
+Renderer::VAO_Handle Renderer::Initialize_Stream(std::string vao_name, Shader_Handle shader, Vertex_Buffer& buffer, Stream_Ring& ring, size_t segment_size) {
+    VAO_Handle vao = Initialize_VAO(vao_name, shader, buffer);
+
+    buffer.ring = &ring;
+    ring.vao = Get_VAO(vao);
+    ring.shader = Get_Shader(shader);
+    ring.segment = Stream_Ring::SEGMENT_COUNT - 1;
+
+    Allocate_Stream(buffer, segment_size);
 
-    return;
+    return vao;
 }
 
-void Renderer::Update_VAO_Buffer(std::string vao_handle, Vertex_Buffer& buffer) {
-    GLuint& vao = vao_map[vao_handle];
-    glBindVertexArray(vao);
+float* Renderer::Map_Stream(Vertex_Buffer& buffer, size_t float_count) {
+    Stream_Ring& ring = *buffer.ring;
+    size_t size = float_count * sizeof(float);
+
+    if (size > ring.segment_size)
+        Resize_Stream(buffer, size * 2);
+
+    ring.segment = (ring.segment + 1) % Stream_Ring::SEGMENT_COUNT;
+    Wait_Fence(ring.fences[ring.segment]);
+
+    size_t offset = ring.segment * ring.segment_size;
+    ring.first_vertex = offset / (buffer.get_size() * sizeof(float));
+    ring.vertex_count = float_count / buffer.get_size();
+    frame_stats.bytes_uploaded += size;
+    frame_stats.buffer_updates++;
 
+    if (ring.persistent)
+        return (float*) (ring.mapped + offset);
+    if (size == 0)
+        return nullptr;
+
+    // Nothing else uses this range until its fence signals, so the driver
+    // does not need to synchronize
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
     glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
-    glBufferData(GL_ARRAY_BUFFER, buffer.stream.size() * sizeof(float), buffer.stream.data(), GL_DYNAMIC_DRAW);
+    ring.mapped = (char*) glMapBufferRange(GL_ARRAY_BUFFER, offset, size, flags);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    return (float*) ring.mapped;
+}
+
+void Renderer::Unmap_Stream(Vertex_Buffer& buffer) {
+    Stream_Ring& ring = *buffer.ring;
+    if (ring.persistent || !ring.mapped)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ring.mapped = nullptr;
 }
 
-void Renderer::Draw(std::string vao_handle, Vertex_Buffer& buffer) {
-    GLuint& vao = vao_map[vao_handle];
+void Renderer::Fence_Stream(Stream_Ring& ring, int segment) {
+    GLsync& fence = ring.fences[segment];
+    if (fence)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
 
-    glBindVertexArray(vao);
+void Renderer::Draw(VAO_Handle vao, Vertex_Buffer& buffer) {
+    glBindVertexArray(Get_VAO(vao));
+
+    if (buffer.ring) {
+        Stream_Ring& ring = *buffer.ring;
+        Draw_Vertices(buffer.primitive, buffer.indexed, ring.first_vertex, ring.vertex_count);
+        frame_stats.draw_calls++;
+        Fence_Stream(ring, ring.segment);
+
+        glBindVertexArray(0);
+        return;
+    }
 
     int primitive_count = 0;
     if (buffer.primitive == GL_TRIANGLES)
         primitive_count = buffer.stream.size() / buffer.get_size();
 
-    glDrawArrays(buffer.primitive, 0, primitive_count);
+    Draw_Vertices(buffer.primitive, buffer.indexed, 0, primitive_count);
+    frame_stats.draw_calls++;
 
     glBindVertexArray(0);
+}
+
+void Renderer::Begin_Frame() {
+    frame_stats = Frame_Stats {};
+}
+
+void Renderer::Sprite_Batch::clear() {
+    buffer.stream.clear();
+    sprite_count = 0;
+}
+
+void Renderer::Sprite_Batch::add(Sprite& sprite) {
+    buffer.stream.insert(buffer.stream.end(), sprite.buffer.stream.begin(), sprite.buffer.stream.end());
+    sprite_count++;
+}
+
+void Renderer::Initialize_Batch(std::string vao_name, Shader_Handle shader, Sprite_Batch& batch, int capacity, const Vertex_Format& format) {
+    // Every quad of the batch shares one vertex layout
+    Sprite sprite_format;
+    Vertex_Buffer& buffer = batch.buffer;
+    buffer.primitive = sprite_format.buffer.primitive;
+    buffer.format = format;
+    buffer.indexed = sprite_format.buffer.indexed;
+
+    buffer.stream.reserve(capacity * QUAD_VERTEX_COUNT * buffer.get_size());
+
+    batch.vao = Initialize_Stream(vao_name, shader, buffer, batch.ring, buffer.stream.capacity() * sizeof(float));
+}
+
+float* Renderer::Map_Batch(Sprite_Batch& batch, int capacity) {
+    Stream_Ring& ring = batch.ring;
+    size_t size = (size_t) capacity * QUAD_VERTEX_COUNT * batch.buffer.get_size() * sizeof(float);
+    batch.write_segment = -1;
+    if (!ring.persistent || size > ring.segment_size)
+        return nullptr;
+
+    int segment = (ring.segment + 1) % Stream_Ring::SEGMENT_COUNT;
+    Wait_Fence(ring.fences[segment]);
+    batch.write_segment = segment;
+    return (float*) (ring.mapped + segment * ring.segment_size);
+}
+
+void Renderer::Commit_Batch(Sprite_Batch& batch, int sprite_count) {
+    assert(batch.write_segment >= 0);
+    Stream_Ring& ring = batch.ring;
+    size_t vertex_bytes = batch.buffer.get_size() * sizeof(float);
+    ring.segment = batch.write_segment;
+    ring.first_vertex = ring.segment * ring.segment_size / vertex_bytes;
+    ring.vertex_count = sprite_count * QUAD_VERTEX_COUNT;
+    frame_stats.bytes_uploaded += ring.vertex_count * vertex_bytes;
+    frame_stats.buffer_updates++;
+
+    batch.write_segment = -1;
+    batch.sprite_count = sprite_count;
+    // The vertices are already in the segment, so there is nothing to copy
+    batch.unchanged = true;
+}
+
+void Renderer::Draw_Batch(Sprite_Batch& batch) {
+    if (batch.sprite_count == 0)
+        return;
+
+    if (!batch.unchanged)
+        Update_VAO_Buffer(batch.vao, batch.buffer);
+    Draw(batch.vao, batch.buffer);
+}
+
+void Renderer::Resident_Batch::mark_dirty(int first, int count) {
+    if (count > 0)
+        dirty.push_back({ first, count });
+}
+
+void Renderer::Initialize_Resident(std::string vao_name, Shader_Handle shader, Resident_Batch& batch, int capacity, GLenum usage) {
+    Sprite sprite_format;
+    Vertex_Buffer& buffer = batch.buffer;
+    buffer.primitive = sprite_format.buffer.primitive;
+    buffer.format = sprite_format.buffer.format;
+    buffer.indexed = sprite_format.buffer.indexed;
+
+    batch.usage = usage;
+    batch.capacity = capacity;
+    batch.vao = Initialize_VAO(vao_name, shader, buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer_object);
+    glBufferData(GL_ARRAY_BUFFER, capacity * QUAD_SIZE * sizeof(float), NULL, usage);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Merges sorted ranges that overlap or lie within max_gap of each other
+static void Merge_Ranges(std::vector<Renderer::Sprite_Range>& ranges, int max_gap) {
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        Renderer::Sprite_Range& current = ranges[merged];
+        const Renderer::Sprite_Range& next = ranges[i];
+        if (next.first <= current.first + current.count + max_gap) {
+            current.count = std::max(current.count, next.first + next.count - current.first);
+        }
+        else {
+            ranges[++merged] = next;
+        }
+    }
+    ranges.resize(merged + 1);
+}
+
+void Renderer::Coalesce_Ranges(std::vector<Sprite_Range>& ranges) {
+    if (ranges.empty())
+        return;
+
+    std::sort(ranges.begin(), ranges.end(), [](const Sprite_Range& a, const Sprite_Range& b) {
+        return a.first < b.first;
+    });
+
+    int max_gap = RANGE_MERGE_GAP;
+    Merge_Ranges(ranges, max_gap);
+    while (ranges.size() > MAX_UPLOAD_RANGES) {
+        max_gap *= 2;
+        Merge_Ranges(ranges, max_gap);
+    }
+}
+
+void Renderer::Upload_Resident(Resident_Batch& batch) {
+    PROFILE_ZONE("upload resident");
+    if (batch.dirty.empty())
+        return;
+
+    const float* vertices = batch.buffer.stream.data();
+    size_t sprite_bytes = QUAD_SIZE * sizeof(float);
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffer.buffer_object);
+
+    // Growing reallocates the buffer object, so everything is sent again
+    if (batch.sprite_count > batch.capacity) {
+        batch.capacity = std::max(batch.sprite_count, batch.capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, batch.capacity * sprite_bytes, NULL, batch.usage);
+        batch.dirty.clear();
+        batch.mark_dirty(0, batch.sprite_count);
+    }
+
+    Coalesce_Ranges(batch.dirty);
+    for (const Sprite_Range& range : batch.dirty) {
+        // Sprites removed since the range was marked need no upload
+        int count = std::min(range.count, batch.sprite_count - range.first);
+        if (count <= 0)
+            continue;
+
+        glBufferSubData(GL_ARRAY_BUFFER, range.first * sprite_bytes, count * sprite_bytes, vertices + range.first * QUAD_SIZE);
+        frame_stats.bytes_uploaded += count * sprite_bytes;
+        frame_stats.buffer_updates++;
+    }
+    batch.dirty.clear();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::Draw_Resident(Resident_Batch& batch) {
+    if (batch.sprite_count == 0)
+        return;
+
+    Upload_Resident(batch);
+
+    glBindVertexArray(Get_VAO(batch.vao));
+    Draw_Vertices(batch.buffer.primitive, batch.buffer.indexed, 0, batch.sprite_count * QUAD_VERTEX_COUNT);
+    frame_stats.draw_calls++;
+    glBindVertexArray(0);
+}
+
+void Renderer::Instance_Batch::clear() {
+    instances.clear();
+}
+
+void Renderer::Instance_Batch::add(Transform& transform, Sprite& sprite) {
+    instances.push_back({ transform.position, transform.scale, sprite.tint, glm::vec4(sprite.uv_rect.min.x, sprite.uv_rect.min.y, sprite.uv_rect.max.x, sprite.uv_rect.max.y) });
+}
+
+void Renderer::Initialize_Instanced(std::string vao_name, Shader_Handle shader_handle, Instance_Batch& batch, int capacity) {
+    GLuint vao;
+    GLuint shader = Get_Shader(shader_handle);
+
+    // Every instance shares the unit quad of a default sprite
+    Sprite sprite_format;
+    batch.vertex_count = sprite_format.mesh.size();
+    batch.capacity = capacity;
+    batch.instances.reserve(capacity);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &batch.mesh_buffer_object);
+    glGenBuffers(1, &batch.instance_buffer_object);
+
+    glBindVertexArray(vao);
+
+    // Upload the quad once
+    glBindBuffer(GL_ARRAY_BUFFER, batch.mesh_buffer_object);
+    glBufferData(GL_ARRAY_BUFFER, sprite_format.mesh.size() * sizeof(glm::vec3), sprite_format.mesh.data(), GL_STATIC_DRAW);
+
+    GLint position_location = glGetAttribLocation(shader, "in_position");
+    if (position_location >= 0) {
+        glVertexAttribPointer(position_location, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*) 0);
+        glEnableVertexAttribArray(position_location);
+    }
+
+    // Per-instance attributes advance once per quad instead of once per vertex
+    glBindBuffer(GL_ARRAY_BUFFER, batch.instance_buffer_object);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), NULL, GL_DYNAMIC_DRAW);
+
+    GLint offset_location = glGetAttribLocation(shader, "in_offset");
+    GLint scale_location = glGetAttribLocation(shader, "in_scale");
+    GLint color_location = glGetAttribLocation(shader, "in_color");
+    GLint uv_rect_location = glGetAttribLocation(shader, "in_uv_rect");
+
+    if (offset_location >= 0) {
+        glVertexAttribPointer(offset_location, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) offsetof(Instance, position));
+        glEnableVertexAttribArray(offset_location);
+        glVertexAttribDivisor(offset_location, 1);
+    }
+    if (scale_location >= 0) {
+        glVertexAttribPointer(scale_location, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) offsetof(Instance, scale));
+        glEnableVertexAttribArray(scale_location);
+        glVertexAttribDivisor(scale_location, 1);
+    }
+    if (color_location >= 0) {
+        glVertexAttribPointer(color_location, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) offsetof(Instance, tint));
+        glEnableVertexAttribArray(color_location);
+        glVertexAttribDivisor(color_location, 1);
+    }
+    if (uv_rect_location >= 0) {
+        glVertexAttribPointer(uv_rect_location, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) offsetof(Instance, uv_rect));
+        glEnableVertexAttribArray(uv_rect_location);
+        glVertexAttribDivisor(uv_rect_location, 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    batch.vao = Register_VAO(vao_name, vao);
+}
+
+void Renderer::Upload_Instances(Instance_Batch& batch) {
+    PROFILE_ZONE("upload instances");
+    glBindBuffer(GL_ARRAY_BUFFER, batch.instance_buffer_object);
+
+    if ((int) batch.instances.size() > batch.capacity) {
+        batch.capacity = batch.instances.size() * 2;
+        glBufferData(GL_ARRAY_BUFFER, batch.capacity * sizeof(Instance), NULL, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, batch.instances.size() * sizeof(Instance), batch.instances.data());
+    frame_stats.bytes_uploaded += batch.instances.size() * sizeof(Instance);
+    frame_stats.buffer_updates++;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "Spatial_Grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static uint64_t Cell_Key(int x, int y) {
+    return ((uint64_t) (uint32_t) x << 32) | (uint32_t) y;
+}
+
+static bool Overlaps(glm::vec2 a_min, glm::vec2 a_max, glm::vec2 b_min, glm::vec2 b_max) {
+    return a_min.x <= b_max.x && a_max.x >= b_min.x
+        && a_min.y <= b_max.y && a_max.y >= b_min.y;
+}
+
+Spatial_Grid::Spatial_Grid(float cell_size)
+    : cell_size(cell_size), inverse_cell_size(1.0f / cell_size) {
+}
+
+glm::ivec2 Spatial_Grid::cell_coordinates(glm::vec2 point) const {
+    return glm::ivec2((int) std::floor(point.x * inverse_cell_size), (int) std::floor(point.y * inverse_cell_size));
+}
+
+bool Spatial_Grid::is_oversized(glm::vec2 min, glm::vec2 max) const {
+    return max.x - min.x > cell_size || max.y - min.y > cell_size;
+}
+
+uint64_t Spatial_Grid::cell_of(glm::vec2 min, glm::vec2 max) const {
+    glm::ivec2 coordinates = cell_coordinates((min + max) * 0.5f);
+    return Cell_Key(coordinates.x, coordinates.y);
+}
+
+// Files the id by the bounds in its entry
+void Spatial_Grid::add_to_list(uint32_t id) {
+    Entry& entry = entries[id];
+    entry.present = true;
+    entry.oversized = is_oversized(entry.min, entry.max);
+
+    std::vector<uint32_t>* ids = &oversized;
+    if (!entry.oversized) {
+        entry.cell = cell_of(entry.min, entry.max);
+        ids = &cells[entry.cell];
+        max_half_extent = glm::max(max_half_extent, (entry.max - entry.min) * 0.5f);
+    }
+    entry.position = ids->size();
+    ids->push_back(id);
+}
+
+void Spatial_Grid::remove_from_list(uint32_t id) {
+    Entry& entry = entries[id];
+    auto cell = cells.end();
+    if (!entry.oversized)
+        cell = cells.find(entry.cell);
+    std::vector<uint32_t>& ids = entry.oversized ? oversized : cell->second;
+
+    // Move the last id of the list into the hole
+    uint32_t last = ids.back();
+    ids[entry.position] = last;
+    entries[last].position = entry.position;
+    ids.pop_back();
+
+    if (!entry.oversized && ids.empty())
+        cells.erase(cell);
+    entry.present = false;
+}
+
+void Spatial_Grid::insert(uint32_t id, glm::vec2 min, glm::vec2 max) {
+    if (id >= entries.size())
+        entries.resize(id + 1);
+    if (entries[id].present)
+        remove_from_list(id);
+
+    entries[id].min = min;
+    entries[id].max = max;
+    add_to_list(id);
+}
+
+void Spatial_Grid::move(uint32_t id, glm::vec2 min, glm::vec2 max) {
+    Entry& entry = entries[id];
+    entry.min = min;
+    entry.max = max;
+
+    bool now_oversized = is_oversized(min, max);
+    if (now_oversized && entry.oversized)
+        return;
+    if (!now_oversized && !entry.oversized && cell_of(min, max) == entry.cell) {
+        max_half_extent = glm::max(max_half_extent, (max - min) * 0.5f);
+        return;
+    }
+
+    remove_from_list(id);
+    add_to_list(id);
+}
+
+bool Spatial_Grid::move_in_place(uint32_t id, glm::vec2 min, glm::vec2 max) {
+    Entry& entry = entries[id];
+    bool now_oversized = is_oversized(min, max);
+    if (now_oversized != entry.oversized)
+        return false;
+    if (!now_oversized) {
+        glm::vec2 half_extent = (max - min) * 0.5f;
+        if (half_extent.x > max_half_extent.x || half_extent.y > max_half_extent.y || cell_of(min, max) != entry.cell)
+            return false;
+    }
+
+    entry.min = min;
+    entry.max = max;
+    return true;
+}
+
+void Spatial_Grid::remove(uint32_t id) {
+    if (contains(id))
+        remove_from_list(id);
+}
+
+bool Spatial_Grid::contains(uint32_t id) const {
+    return id < entries.size() && entries[id].present;
+}
+
+void Spatial_Grid::query(glm::vec2 min, glm::vec2 max, std::vector<uint32_t>& out) const {
+    auto collect = [&](const std::vector<uint32_t>& ids) {
+        for (uint32_t id : ids) {
+            const Entry& entry = entries[id];
+            if (Overlaps(entry.min, entry.max, min, max))
+                out.push_back(id);
+        }
+    };
+    collect(oversized);
+
+    glm::ivec2 first = cell_coordinates(min - max_half_extent);
+    glm::ivec2 last = cell_coordinates(max + max_half_extent);
+
+    // A box covering more cells than are occupied is cheaper to answer by
+    // walking the occupied cells
+    double range = (double) (last.x - first.x + 1) * (last.y - first.y + 1);
+    if (range > (double) cells.size()) {
+        for (const auto& cell : cells) {
+            int x = (int) (uint32_t) (cell.first >> 32);
+            int y = (int) (uint32_t) cell.first;
+            if (x >= first.x && x <= last.x && y >= first.y && y <= last.y)
+                collect(cell.second);
+        }
+        return;
+    }
+
+    for (int y = first.y; y <= last.y; ++y) {
+        for (int x = first.x; x <= last.x; ++x) {
+            auto cell = cells.find(Cell_Key(x, y));
+            if (cell != cells.end())
+                collect(cell->second);
+        }
+    }
+}
+
+void Spatial_Grid::clear() {
+    cells.clear();
+    oversized.clear();
+    entries.clear();
+    max_half_extent = glm::vec2(0.0f);
+}
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "Text.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "Vertex_Kernel.hpp"
+#include "Profiler.hpp"
+
+using Vertex_Kernel::QUAD_VERTEX_COUNT;
+
+// font8x8_basic by Daniel Hepper, public domain. One byte per row, top row
+// first; bit 0 is the leftmost pixel.
+static const uint8_t FONT_8X8[Renderer::GLYPH_COUNT][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 }, // !
+    { 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+    { 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 }, // #
+    { 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 }, // $
+    { 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 }, // %
+    { 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 }, // &
+    { 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+    { 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 }, // (
+    { 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 }, // )
+    { 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 }, // *
+    { 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 }, // +
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ,
+    { 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 }, // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // .
+    { 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 }, // /
+    { 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 }, // 0
+    { 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 }, // 1
+    { 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 }, // 2
+    { 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 }, // 3
+    { 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 }, // 4
+    { 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 }, // 5
+    { 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 }, // 6
+    { 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 }, // 7
+    { 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 }, // 8
+    { 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 }, // 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // :
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ;
+    { 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 }, // <
+    { 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 }, // =
+    { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, // >
+    { 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 }, // ?
+    { 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 }, // @
+    { 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 }, // A
+    { 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 }, // B
+    { 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 }, // C
+    { 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 }, // D
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 }, // E
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 }, // F
+    { 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 }, // G
+    { 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 }, // H
+    { 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // I
+    { 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 }, // J
+    { 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 }, // K
+    { 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 }, // L
+    { 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 }, // M
+    { 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 }, // N
+    { 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 }, // O
+    { 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 }, // P
+    { 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 }, // Q
+    { 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 }, // R
+    { 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 }, // S
+    { 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // T
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 }, // U
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // V
+    { 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 }, // W
+    { 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 }, // X
+    { 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 }, // Y
+    { 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 }, // Z
+    { 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 }, // [
+    { 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 }, // backslash
+    { 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 }, // ]
+    { 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 }, // ^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }, // _
+    { 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 }, // `
+    { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // a
+    { 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 }, // b
+    { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // c
+    { 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 }, // d
+    { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // e
+    { 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 }, // f
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // g
+    { 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 }, // h
+    { 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // i
+    { 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E }, // j
+    { 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 }, // k
+    { 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // l
+    { 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 }, // m
+    { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // n
+    { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // o
+    { 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F }, // p
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 }, // q
+    { 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 }, // r
+    { 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 }, // s
+    { 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 }, // t
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 }, // u
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // v
+    { 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 }, // w
+    { 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 }, // x
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // y
+    { 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 }, // z
+    { 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 }, // {
+    { 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 }, // |
+    { 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 }, // }
+    { 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ~
+};
+
+constexpr int FONT_SIZE = 8;
+constexpr int ATLAS_COLUMNS = 16;
+constexpr int MISSING_GLYPH = '?' - Renderer::FIRST_GLYPH;
+
+static int Glyph_Index(char character) {
+    int glyph = (unsigned char) character - Renderer::FIRST_GLYPH;
+    return glyph >= 0 && glyph < Renderer::GLYPH_COUNT ? glyph : MISSING_GLYPH;
+}
+
+// Pixels outside the 8x8 box count as empty
+static bool Font_Pixel(int glyph, int column, int row) {
+    if (column < 0 || column >= FONT_SIZE || row < 0 || row >= FONT_SIZE)
+        return false;
+    return (FONT_8X8[glyph][row] >> column) & 1;
+}
+
+// Distance in font pixels from (x, y) to the nearest pixel square that is
+// filled when `filled` is set, otherwise empty. The ring around the box
+// stands in for all the empty space beyond it.
+static float Distance_To_Pixels(int glyph, float x, float y, bool filled) {
+    float nearest = FLT_MAX;
+    for (int row = -1; row <= FONT_SIZE; ++row) {
+        for (int column = -1; column <= FONT_SIZE; ++column) {
+            if (Font_Pixel(glyph, column, row) != filled)
+                continue;
+            float dx = std::max(std::fabs(x - (column + 0.5f)) - 0.5f, 0.0f);
+            float dy = std::max(std::fabs(y - (row + 0.5f)) - 0.5f, 0.0f);
+            nearest = std::min(nearest, dx * dx + dy * dy);
+        }
+    }
+    return std::sqrt(nearest);
+}
+
+void Renderer::Build_Glyph_Atlas(Glyph_Atlas& atlas, int glyph_size, int spread) {
+    PROFILE_ZONE("build glyph atlas");
+
+    int rows = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+    atlas.cell_size = glyph_size + 2 * spread;
+    atlas.glyph_share = (float) glyph_size / atlas.cell_size;
+    atlas.width = ATLAS_COLUMNS * atlas.cell_size;
+    atlas.height = rows * atlas.cell_size;
+    atlas.distances.assign((size_t) atlas.width * atlas.height, 0);
+
+    float texels_per_pixel = (float) glyph_size / FONT_SIZE;
+    for (int glyph = 0; glyph < GLYPH_COUNT; ++glyph) {
+        int cell_x = (glyph % ATLAS_COLUMNS) * atlas.cell_size;
+        int cell_y = (glyph / ATLAS_COLUMNS) * atlas.cell_size;
+
+        for (int ty = 0; ty < atlas.cell_size; ++ty) {
+            // Texture rows go up, font rows go down
+            float y = FONT_SIZE - (ty + 0.5f - spread) / texels_per_pixel;
+            for (int tx = 0; tx < atlas.cell_size; ++tx) {
+                float x = (tx + 0.5f - spread) / texels_per_pixel;
+
+                bool inside = Font_Pixel(glyph, (int) std::floor(x), (int) std::floor(y));
+                float distance = Distance_To_Pixels(glyph, x, y, !inside) * texels_per_pixel;
+                if (inside)
+                    distance = -distance;
+
+                float value = std::clamp(0.5f - distance / (2.0f * spread), 0.0f, 1.0f);
+                atlas.distances[(size_t) (cell_y + ty) * atlas.width + cell_x + tx] = (uint8_t) (value * 255.0f + 0.5f);
+            }
+        }
+
+        uint16_t* cell = atlas.cells[glyph];
+        cell[0] = (uint16_t) std::lround(65535.0 * cell_x / atlas.width);
+        cell[1] = (uint16_t) std::lround(65535.0 * cell_y / atlas.height);
+        cell[2] = (uint16_t) std::lround(65535.0 * (cell_x + atlas.cell_size) / atlas.width);
+        cell[3] = (uint16_t) std::lround(65535.0 * (cell_y + atlas.cell_size) / atlas.height);
+    }
+}
+
+void Renderer::Upload_Glyph_Atlas(Glyph_Atlas& atlas) {
+    if (atlas.texture == 0)
+        glGenTextures(1, &atlas.texture);
+
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas.width, atlas.height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.distances.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Distances interpolate linearly, which is what keeps scaled edges smooth
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::Layout_Text(const std::string& text, float size, float max_width, Text_Layout& layout) {
+    layout.quads.clear();
+    layout.size = { 0.0f, 0.0f };
+    if (text.empty())
+        return;
+
+    float pen_x = 0.0f;
+    float pen_y = 0.0f;
+    size_t i = 0;
+    while (i < text.size()) {
+        char character = text[i];
+        if (character == '\n') {
+            layout.size.x = std::max(layout.size.x, pen_x);
+            pen_x = 0.0f;
+            pen_y += size;
+            ++i;
+            continue;
+        }
+        if (character == ' ') {
+            pen_x += size;
+            ++i;
+            continue;
+        }
+
+        // Words move to the next line whole unless they start it
+        size_t end = text.find_first_of(" \n", i);
+        if (end == std::string::npos)
+            end = text.size();
+        float word_width = (end - i) * size;
+        if (max_width > 0.0f && pen_x > 0.0f && pen_x + word_width > max_width) {
+            layout.size.x = std::max(layout.size.x, pen_x);
+            pen_x = 0.0f;
+            pen_y += size;
+        }
+
+        for (; i < end; ++i) {
+            layout.quads.push_back({ { pen_x, pen_y }, { pen_x + size, pen_y + size }, Glyph_Index(text[i]) });
+            pen_x += size;
+        }
+    }
+    layout.size.x = std::max(layout.size.x, pen_x);
+    layout.size.y = pen_y + size;
+}
+
+// FNV-1a over the string and the layout parameters
+static uint64_t Hash_Text(const std::string& text, float size, float max_width) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t length) {
+        const uint8_t* bytes = (const uint8_t*) data;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(text.data(), text.size());
+    mix(&size, sizeof(size));
+    mix(&max_width, sizeof(max_width));
+    return hash;
+}
+
+const Renderer::Text_Layout& Renderer::Text_Cache::get(const std::string& text, float size, float max_width) {
+    Entry& entry = entries[Hash_Text(text, size, max_width)];
+    entry.last_used = frame;
+
+    // A fresh entry, or a colliding string taking its slot over
+    if (entry.text != text || entry.size != size || entry.max_width != max_width) {
+        entry.text = text;
+        entry.size = size;
+        entry.max_width = max_width;
+        Layout_Text(text, size, max_width, entry.layout);
+        misses++;
+    }
+    else {
+        hits++;
+    }
+    return entry.layout;
+}
+
+void Renderer::Text_Cache::end_frame() {
+    frame++;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (frame - it->second.last_used > max_age)
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void Renderer::Add_Layout(Sprite_Batch& batch, const Glyph_Atlas& atlas, const Text_Layout& layout, glm::vec2 position, glm::vec3 color) {
+    // Words of TEXTURED_SPRITE_FORMAT: x, y, color, packed texcoord
+    constexpr int WORDS = 4;
+    uint32_t packed_color = Vertex_Kernel::Pack_Color(color);
+
+    std::vector<float>& stream = batch.buffer.stream;
+    size_t start = stream.size();
+    stream.resize(start + layout.quads.size() * QUAD_VERTEX_COUNT * WORDS);
+    float* out = stream.data() + start;
+
+    for (const Glyph_Quad& quad : layout.quads) {
+        // The quad covers the whole cell, spread included
+        float margin = (quad.max.x - quad.min.x) * (1.0f - atlas.glyph_share) / (2.0f * atlas.glyph_share);
+        float left = position.x + quad.min.x - margin;
+        float right = position.x + quad.max.x + margin;
+        // Layouts run down from the top left; the screen's y axis points up
+        float top = position.y - quad.min.y + margin;
+        float bottom = position.y - quad.max.y - margin;
+        const uint16_t* cell = atlas.cells[quad.glyph];
+
+        // Corners in Vertex_Kernel::QUAD_CORNERS order
+        const float corners[QUAD_VERTEX_COUNT][2] = { { left, bottom }, { right, bottom }, { right, top }, { left, top } };
+        const uint32_t texcoords[QUAD_VERTEX_COUNT] = {
+            cell[0] | ((uint32_t) cell[1] << 16),
+            cell[2] | ((uint32_t) cell[1] << 16),
+            cell[2] | ((uint32_t) cell[3] << 16),
+            cell[0] | ((uint32_t) cell[3] << 16),
+        };
+        for (int v = 0; v < QUAD_VERTEX_COUNT; ++v) {
+            std::memcpy(&out[0], corners[v], sizeof(corners[v]));
+            std::memcpy(&out[2], &packed_color, sizeof(packed_color));
+            std::memcpy(&out[3], &texcoords[v], sizeof(texcoords[v]));
+            out += WORDS;
+        }
+    }
+    batch.sprite_count += layout.quads.size();
+}
+
+void Renderer::Add_Text(Sprite_Batch& batch, Text_Cache& cache, const Glyph_Atlas& atlas, const Text& text) {
+    const Text_Layout& layout = cache.get(text.string, text.size, text.max_width);
+    Add_Layout(batch, atlas, layout, text.position, text.color);
+}
\ No newline at end of file
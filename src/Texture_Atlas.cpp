@@ -0,0 +1,408 @@
+#include "Texture_Atlas.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "Job_System.hpp"
+
+// TGA image types
+constexpr uint8_t TGA_TRUECOLOR = 2;
+constexpr uint8_t TGA_GRAYSCALE = 3;
+constexpr uint8_t TGA_RLE_TRUECOLOR = 10;
+constexpr uint8_t TGA_RLE_GRAYSCALE = 11;
+
+constexpr int TGA_HEADER_SIZE = 18;
+// Descriptor bit set when the first row is the top one
+constexpr uint8_t TGA_TOP_ORIGIN = 0x20;
+
+// Converts one BGR(A) or gray pixel to RGBA
+static void Read_Pixel(const uint8_t* source, int bytes_per_pixel, uint8_t* destination) {
+    if (bytes_per_pixel == 1) {
+        destination[0] = destination[1] = destination[2] = source[0];
+        destination[3] = 255;
+        return;
+    }
+    destination[0] = source[2];
+    destination[1] = source[1];
+    destination[2] = source[0];
+    destination[3] = bytes_per_pixel == 4 ? source[3] : 255;
+}
+
+bool Renderer::Load_TGA(const std::string& filename, Image& image) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < TGA_HEADER_SIZE)
+        return false;
+
+    uint8_t id_length = data[0];
+    uint8_t colormap_type = data[1];
+    uint8_t image_type = data[2];
+    int width = data[12] | (data[13] << 8);
+    int height = data[14] | (data[15] << 8);
+    int bytes_per_pixel = data[16] / 8;
+    uint8_t descriptor = data[17];
+
+    bool is_rle = image_type == TGA_RLE_TRUECOLOR || image_type == TGA_RLE_GRAYSCALE;
+    bool is_gray = image_type == TGA_GRAYSCALE || image_type == TGA_RLE_GRAYSCALE;
+    bool is_color = image_type == TGA_TRUECOLOR || image_type == TGA_RLE_TRUECOLOR;
+    if (colormap_type != 0 || !(is_gray || is_color) || width <= 0 || height <= 0)
+        return false;
+    if (is_gray ? bytes_per_pixel != 1 : (bytes_per_pixel != 3 && bytes_per_pixel != 4))
+        return false;
+
+    size_t pixel_count = (size_t) width * height;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(pixel_count * 4);
+
+    const uint8_t* source = data.data() + TGA_HEADER_SIZE + id_length;
+    const uint8_t* end = data.data() + data.size();
+    uint8_t* destination = image.pixels.data();
+
+    if (!is_rle) {
+        if ((size_t) (end - source) < pixel_count * bytes_per_pixel)
+            return false;
+        for (size_t i = 0; i < pixel_count; ++i) {
+            Read_Pixel(source, bytes_per_pixel, destination);
+            source += bytes_per_pixel;
+            destination += 4;
+        }
+    }
+    else {
+        // Packets of up to 128 pixels, either one repeated value or raw values
+        size_t written = 0;
+        while (written < pixel_count) {
+            if (source >= end)
+                return false;
+            uint8_t packet = *source++;
+            size_t run = std::min<size_t>((packet & 0x7F) + 1, pixel_count - written);
+            bool is_repeat = packet & 0x80;
+
+            size_t bytes_needed = (is_repeat ? 1 : run) * bytes_per_pixel;
+            if ((size_t) (end - source) < bytes_needed)
+                return false;
+
+            for (size_t i = 0; i < run; ++i) {
+                Read_Pixel(source, bytes_per_pixel, destination);
+                if (!is_repeat)
+                    source += bytes_per_pixel;
+                destination += 4;
+            }
+            if (is_repeat)
+                source += bytes_per_pixel;
+            written += run;
+        }
+    }
+
+    // Rows are stored bottom first unless the descriptor says otherwise
+    if (descriptor & TGA_TOP_ORIGIN) {
+        size_t row_size = (size_t) width * 4;
+        for (int row = 0; row < height / 2; ++row)
+            std::swap_ranges(image.pixels.begin() + row * row_size,
+                             image.pixels.begin() + (row + 1) * row_size,
+                             image.pixels.begin() + (height - 1 - row) * row_size);
+    }
+
+    return true;
+}
+
+bool Renderer::Save_TGA(const std::string& filename, const Image& image) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint8_t header[TGA_HEADER_SIZE] = {};
+    header[2] = TGA_TRUECOLOR;
+    header[12] = image.width & 0xFF;
+    header[13] = (image.width >> 8) & 0xFF;
+    header[14] = image.height & 0xFF;
+    header[15] = (image.height >> 8) & 0xFF;
+    header[16] = 32;
+    header[17] = 8;     // Alpha bits
+    file.write((const char*) header, TGA_HEADER_SIZE);
+
+    std::vector<uint8_t> bgra(image.pixels.size());
+    for (size_t i = 0; i < image.pixels.size(); i += 4) {
+        bgra[i + 0] = image.pixels[i + 2];
+        bgra[i + 1] = image.pixels[i + 1];
+        bgra[i + 2] = image.pixels[i + 0];
+        bgra[i + 3] = image.pixels[i + 3];
+    }
+    file.write((const char*) bgra.data(), bgra.size());
+
+    return (bool) file;
+}
+
+void Renderer::Skyline_Packer::reset(int atlas_width, int atlas_height) {
+    width = atlas_width;
+    height = atlas_height;
+    skyline.clear();
+    skyline.push_back({ 0, 0, width });
+}
+
+// Height at which a rectangle starting at segment `index` rests, or false when
+// it runs past the right or top edge
+static bool Fit(const Renderer::Skyline_Packer& packer, size_t index, int rect_width, int rect_height, int& y) {
+    const Renderer::Skyline_Packer::Segment& first = packer.skyline[index];
+    if (first.x + rect_width > packer.width)
+        return false;
+
+    y = first.y;
+    int width_left = rect_width;
+    for (size_t i = index; width_left > 0; ++i) {
+        y = std::max(y, packer.skyline[i].y);
+        if (y + rect_height > packer.height)
+            return false;
+        width_left -= packer.skyline[i].width;
+    }
+
+    return true;
+}
+
+bool Renderer::Skyline_Packer::insert(int rect_width, int rect_height, int& x, int& y) {
+    int best_y = INT_MAX;
+    int best_width = INT_MAX;
+    size_t best_index = SIZE_MAX;
+
+    for (size_t i = 0; i < skyline.size(); ++i) {
+        int fit_y;
+        if (!Fit(*this, i, rect_width, rect_height, fit_y))
+            continue;
+        if (fit_y < best_y || (fit_y == best_y && skyline[i].width < best_width)) {
+            best_y = fit_y;
+            best_width = skyline[i].width;
+            best_index = i;
+        }
+    }
+
+    if (best_index == SIZE_MAX)
+        return false;
+
+    x = skyline[best_index].x;
+    y = best_y;
+
+    // Raise the skyline over the new rectangle and trim the segments it covers
+    skyline.insert(skyline.begin() + best_index, { x, y + rect_height, rect_width });
+    for (size_t i = best_index + 1; i < skyline.size();) {
+        Segment& previous = skyline[i - 1];
+        Segment& segment = skyline[i];
+        int overlap = previous.x + previous.width - segment.x;
+        if (overlap <= 0)
+            break;
+
+        segment.x += overlap;
+        segment.width -= overlap;
+        if (segment.width > 0)
+            break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Merge neighbours at the same height
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    return true;
+}
+
+static int Next_Power_Of_Two(int value) {
+    int power = 1;
+    while (power < value)
+        power *= 2;
+    return power;
+}
+
+bool Renderer::Build_Atlas(Texture_Atlas& atlas, const std::vector<std::string>& names, const std::vector<Image>& images, int max_size, int padding) {
+    // Tall images first keeps the skyline flat
+    std::vector<size_t> order(images.size());
+    size_t image_area = 0;
+    size_t padded_area = 0;
+    for (size_t i = 0; i < images.size(); ++i) {
+        order[i] = i;
+        image_area += (size_t) images[i].width * images[i].height;
+        padded_area += (size_t) (images[i].width + 2 * padding) * (images[i].height + 2 * padding);
+    }
+    std::sort(order.begin(), order.end(), [&images](size_t a, size_t b) {
+        if (images[a].height != images[b].height)
+            return images[a].height > images[b].height;
+        return images[a].width > images[b].width;
+    });
+
+    // Pack into a strip of power-of-two width, starting at about the side of a
+    // square holding everything, and widen it until everything fits. The
+    // height is then trimmed to the top of the skyline; core GL takes non
+    // power-of-two textures.
+    int widest = 1;
+    for (const Image& image : images)
+        widest = std::max(widest, image.width + 2 * padding);
+    int width = std::max(Next_Power_Of_Two((int) std::ceil(std::sqrt((double) padded_area))) / 2, Next_Power_Of_Two(widest));
+    if (width > max_size)
+        return false;
+
+    Skyline_Packer packer;
+    std::vector<int> xs(images.size());
+    std::vector<int> ys(images.size());
+    while (true) {
+        packer.reset(width, max_size);
+
+        bool packed = true;
+        for (size_t i : order) {
+            if (!packer.insert(images[i].width + 2 * padding, images[i].height + 2 * padding, xs[i], ys[i])) {
+                packed = false;
+                break;
+            }
+        }
+        if (packed)
+            break;
+
+        width *= 2;
+        if (width > max_size)
+            return false;
+    }
+
+    int height = 1;
+    for (const Skyline_Packer::Segment& segment : packer.skyline)
+        height = std::max(height, segment.y);
+
+    Image& target = atlas.image;
+    target.width = width;
+    target.height = height;
+    target.pixels.assign((size_t) width * height * 4, 0);
+    atlas.regions.clear();
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        const Image& source = images[i];
+
+        // Copy the image with its edge pixels extruded into the padding
+        for (int row = 0; row < source.height + 2 * padding; ++row) {
+            int source_row = std::clamp(row - padding, 0, source.height - 1);
+            uint8_t* destination = &target.pixels[((size_t) (ys[i] + row) * width + xs[i]) * 4];
+            for (int column = 0; column < source.width + 2 * padding; ++column) {
+                int source_column = std::clamp(column - padding, 0, source.width - 1);
+                const uint8_t* pixel = &source.pixels[((size_t) source_row * source.width + source_column) * 4];
+                std::copy(pixel, pixel + 4, destination + column * 4);
+            }
+        }
+
+        UV_Rect region;
+        region.min = glm::vec2((float) (xs[i] + padding) / width, (float) (ys[i] + padding) / height);
+        region.max = glm::vec2((float) (xs[i] + padding + source.width) / width, (float) (ys[i] + padding + source.height) / height);
+        atlas.regions[names[i]] = region;
+    }
+
+    atlas.efficiency = (float) ((double) image_area / ((double) width * height));
+
+    return true;
+}
+
+void Renderer::Upload_Atlas(Texture_Atlas& atlas) {
+    if (atlas.texture == 0)
+        glGenTextures(1, &atlas.texture);
+
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas.image.width, atlas.image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas.image.pixels.data());
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool Renderer::Load_Images(const std::string& directory, std::vector<std::string>& names, std::vector<Image>& images) {
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".tga")
+            files.push_back(entry.path());
+    }
+    // Directory order is unspecified; sorting keeps the layout reproducible
+    std::sort(files.begin(), files.end());
+
+    names.assign(files.size(), std::string());
+    images.assign(files.size(), Image {});
+    std::vector<uint8_t> loaded(files.size());
+
+    // Decoding is independent per file, so spread it over the job system
+    Jobs::Parallel_For(files.size(), 16, [&](int first, int count) {
+        for (int i = first; i < first + count; ++i) {
+            names[i] = files[i].stem().string();
+            loaded[i] = Load_TGA(files[i].string(), images[i]);
+        }
+    });
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!loaded[i]) {
+            std::cout << "ERROR::ATLAS::IMAGE_LOAD_FAILED\n" << files[i].string() << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Renderer::Load_Atlas(Texture_Atlas& atlas, const std::string& directory, int max_size) {
+    std::vector<std::string> names;
+    std::vector<Image> images;
+    if (!Load_Images(directory, names, images))
+        return false;
+
+    if (!Build_Atlas(atlas, names, images, max_size)) {
+        std::cout << "ERROR::ATLAS::PACKING_FAILED\n" << directory << std::endl;
+        return false;
+    }
+
+    Upload_Atlas(atlas);
+
+    return true;
+}
+
+bool Renderer::Load_Atlas(Texture_Atlas& atlas, const Asset_Pack::Pack& pack, int max_size) {
+    std::vector<std::string> names;
+    std::vector<Image> images;
+    for (uint32_t s = 0; pack.header && s < pack.header->section_count; ++s) {
+        const Asset_Pack::Section& section = pack.sections[s];
+        Asset_Pack::Texture_View texture;
+        if (section.type != Asset_Pack::SECTION_TEXTURE || !Asset_Pack::Get_Texture(pack, section.name, texture))
+            continue;
+
+        Image image;
+        image.width = texture.width;
+        image.height = texture.height;
+        image.pixels.assign(texture.pixels, texture.pixels + (size_t) texture.width * texture.height * 4);
+        names.push_back(section.name);
+        images.push_back(std::move(image));
+    }
+
+    if (images.empty() || !Build_Atlas(atlas, names, images, max_size)) {
+        std::cout << "ERROR::ATLAS::PACKING_FAILED\nasset pack" << std::endl;
+        return false;
+    }
+
+    Upload_Atlas(atlas);
+
+    return true;
+}
+
+UV_Rect Renderer::Find_Region(const Texture_Atlas& atlas, const std::string& name) {
+    auto region = atlas.regions.find(name);
+    if (region == atlas.regions.end())
+        return UV_Rect {};
+    return region->second;
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "Tilemap.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "Vertex_Kernel.hpp"
+#include "Profiler.hpp"
+
+using Vertex_Kernel::QUAD_SIZE;
+using Vertex_Kernel::QUAD_VERTEX_COUNT;
+using Vertex_Kernel::VERTEX_SIZE;
+
+constexpr size_t SLOT_BYTES = Renderer::CHUNK_QUADS * QUAD_SIZE * sizeof(float);
+
+void Renderer::Tilemap::resize(int tile_width, int tile_height) {
+    chunks_x = (std::max(tile_width, 0) + CHUNK_TILES - 1) / CHUNK_TILES;
+    chunks_y = (std::max(tile_height, 0) + CHUNK_TILES - 1) / CHUNK_TILES;
+    width = chunks_x * CHUNK_TILES;
+    height = chunks_y * CHUNK_TILES;
+
+    tiles.assign((size_t) width * height, EMPTY_TILE);
+    chunks.assign((size_t) chunks_x * chunks_y, Tile_Chunk {});
+    visible.clear();
+    for (int32_t& owner : slots)
+        owner = -1;
+}
+
+// Chunk and position inside it of a tile
+static size_t Tile_Index(const Renderer::Tilemap& map, int x, int y, uint32_t& chunk) {
+    using Renderer::CHUNK_TILES;
+    chunk = (y / CHUNK_TILES) * map.chunks_x + x / CHUNK_TILES;
+    return (size_t) chunk * Renderer::CHUNK_QUADS + (y % CHUNK_TILES) * CHUNK_TILES + x % CHUNK_TILES;
+}
+
+int32_t Renderer::Tilemap::chunk_of(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return -1;
+
+    uint32_t chunk;
+    Tile_Index(*this, x, y, chunk);
+    return chunk;
+}
+
+uint16_t Renderer::Tilemap::get(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return EMPTY_TILE;
+
+    uint32_t chunk;
+    return tiles[Tile_Index(*this, x, y, chunk)];
+}
+
+void Renderer::Tilemap::set(int x, int y, uint16_t tile) {
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return;
+
+    uint32_t chunk;
+    uint16_t& current = tiles[Tile_Index(*this, x, y, chunk)];
+    if (current == tile)
+        return;
+    current = tile;
+    chunks[chunk].revision++;
+}
+
+int Renderer::Build_Chunk_Mesh(const Tilemap& map, uint32_t chunk, std::vector<float>& mesh) {
+    // Sized for a full chunk and trimmed after, so the loop writes through a
+    // plain pointer
+    mesh.resize(CHUNK_QUADS * QUAD_SIZE);
+    float* out = mesh.data();
+
+    const uint16_t* tiles = &map.tiles[(size_t) chunk * CHUNK_QUADS];
+    glm::vec2 base = map.origin + glm::vec2(chunk % map.chunks_x, chunk / map.chunks_x) * (map.tile_size * CHUNK_TILES);
+    uint16_t palette_size = (uint16_t) std::min<size_t>(map.palette.size(), UINT16_MAX);
+
+    int quad_count = 0;
+    for (int y = 0; y < CHUNK_TILES; ++y) {
+        float min_y = base.y + y * map.tile_size;
+        float max_y = min_y + map.tile_size;
+        for (int x = 0; x < CHUNK_TILES; ++x) {
+            uint16_t tile = tiles[y * CHUNK_TILES + x];
+            if (tile == EMPTY_TILE || tile >= palette_size)
+                continue;
+
+            float min_x = base.x + x * map.tile_size;
+            float max_x = min_x + map.tile_size;
+            // Corners in the order of Vertex_Kernel::QUAD_CORNERS
+            const float corners[QUAD_VERTEX_COUNT][2] = { { min_x, min_y }, { max_x, min_y }, { max_x, max_y }, { min_x, max_y } };
+            for (int v = 0; v < QUAD_VERTEX_COUNT; ++v) {
+                out[0] = corners[v][0];
+                out[1] = corners[v][1];
+                std::memcpy(&out[2], &map.palette[tile], sizeof(uint32_t));
+                out += VERTEX_SIZE;
+            }
+            quad_count++;
+        }
+    }
+
+    mesh.resize(quad_count * QUAD_SIZE);
+    return quad_count;
+}
+
+static void Release_Slot(Renderer::Tilemap& map, Renderer::Tile_Chunk& chunk) {
+    map.slots[chunk.slot] = -1;
+    chunk.slot = -1;
+    chunk.uploaded_revision = 0;
+    chunk.uploaded_quads = 0;
+}
+
+// Takes the slot back from a chunk with tiles. Its mesh was freed after the
+// upload, so it is built again when next in view.
+static void Evict_Chunk(Renderer::Tilemap& map, Renderer::Tile_Chunk& chunk) {
+    Release_Slot(map, chunk);
+    chunk.built_revision = 0;
+    chunk.quad_count = 0;
+}
+
+// Every chunk gives up its slot
+static void Resize_Slots(Renderer::Tilemap& map, int slot_count) {
+    for (int32_t owner : map.slots) {
+        if (owner >= 0)
+            Evict_Chunk(map, map.chunks[owner]);
+    }
+    map.slots.assign(slot_count, -1);
+}
+
+// Reallocates the buffer object for map.slots; its contents are lost
+static void Allocate_Slots(Renderer::Tilemap& map) {
+    glBindBuffer(GL_ARRAY_BUFFER, map.buffer.buffer_object);
+    glBufferData(GL_ARRAY_BUFFER, map.slots.size() * SLOT_BYTES, NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::Initialize_Tilemap(std::string vao_name, Shader_Handle shader, Tilemap& map, int slot_count) {
+    Sprite sprite_format;
+    Vertex_Buffer& buffer = map.buffer;
+    buffer.primitive = sprite_format.buffer.primitive;
+    buffer.format = sprite_format.buffer.format;
+    buffer.indexed = sprite_format.buffer.indexed;
+
+    map.vao = Initialize_VAO(vao_name, shader, buffer);
+    Reserve_Quad_Indices(CHUNK_QUADS);
+    Resize_Slots(map, std::max(slot_count, 1));
+    Allocate_Slots(map);
+}
+
+void Renderer::Update_Tilemap(Tilemap& map, glm::vec2 view_min, glm::vec2 view_max) {
+    PROFILE_ZONE("update tilemap");
+
+    map.frame++;
+    map.visible.clear();
+
+    float chunk_size = map.tile_size * CHUNK_TILES;
+    glm::vec2 first = (view_min - map.origin) / chunk_size;
+    glm::vec2 last = (view_max - map.origin) / chunk_size;
+    if (last.x < 0.0f || last.y < 0.0f || first.x >= map.chunks_x || first.y >= map.chunks_y)
+        return;
+
+    int first_x = std::max((int) std::floor(first.x), 0);
+    int first_y = std::max((int) std::floor(first.y), 0);
+    int last_x = std::min((int) std::floor(last.x), map.chunks_x - 1);
+    int last_y = std::min((int) std::floor(last.y), map.chunks_y - 1);
+
+    int build_count = 0;
+    for (int y = first_y; y <= last_y; ++y) {
+        for (int x = first_x; x <= last_x; ++x) {
+            uint32_t id = y * map.chunks_x + x;
+            Tile_Chunk& chunk = map.chunks[id];
+            chunk.last_visible = map.frame;
+            map.visible.push_back(id);
+
+            if (chunk.built_revision == chunk.revision || build_count == map.max_builds_per_frame)
+                continue;
+
+            // The job owns the mesh until Upload_Tilemap waits for it
+            chunk.built_revision = chunk.revision;
+            build_count++;
+            Jobs::Run(map.builds, [&map, id] {
+                Tile_Chunk& chunk = map.chunks[id];
+                chunk.quad_count = Build_Chunk_Mesh(map, id, chunk.mesh);
+            });
+        }
+    }
+}
+
+// A free slot, or the one whose chunk has been out of view longest
+static int Acquire_Slot(Renderer::Tilemap& map) {
+    int best = -1;
+    uint32_t oldest = map.frame;
+    for (int s = 0; s < (int) map.slots.size(); ++s) {
+        int32_t owner = map.slots[s];
+        if (owner < 0)
+            return s;
+
+        uint32_t last_visible = map.chunks[owner].last_visible;
+        if (last_visible < oldest) {
+            oldest = last_visible;
+            best = s;
+        }
+    }
+
+    // The pool holds at least one slot per visible chunk with tiles, and the
+    // ones held by visible chunks without tiles are freed first, so some
+    // slot always belongs to a chunk out of view
+    assert(best >= 0);
+    Evict_Chunk(map, map.chunks[map.slots[best]]);
+    return best;
+}
+
+bool Renderer::Assign_Tilemap_Slots(Tilemap& map, std::vector<uint32_t>& uploads) {
+    uploads.clear();
+
+    // Edited down to no tiles
+    int needed = 0;
+    for (uint32_t id : map.visible) {
+        Tile_Chunk& chunk = map.chunks[id];
+        if (chunk.quad_count > 0)
+            needed++;
+        else if (chunk.slot >= 0)
+            Release_Slot(map, chunk);
+    }
+
+    bool grew = needed > (int) map.slots.size();
+    if (grew)
+        Resize_Slots(map, std::max(needed, (int) map.slots.size() * 2));
+
+    for (uint32_t id : map.visible) {
+        Tile_Chunk& chunk = map.chunks[id];
+        if (chunk.quad_count == 0 || (chunk.slot >= 0 && chunk.uploaded_revision == chunk.built_revision))
+            continue;
+
+        if (chunk.slot < 0) {
+            chunk.slot = Acquire_Slot(map);
+            map.slots[chunk.slot] = id;
+        }
+        uploads.push_back(id);
+    }
+    return grew;
+}
+
+void Renderer::Upload_Tilemap(Tilemap& map) {
+    PROFILE_ZONE("upload tilemap");
+
+    {
+        PROFILE_ZONE("wait chunk builds");
+        Jobs::Wait(map.builds);
+    }
+
+    if (Assign_Tilemap_Slots(map, map.uploads))
+        Allocate_Slots(map);
+
+    glBindBuffer(GL_ARRAY_BUFFER, map.buffer.buffer_object);
+    for (uint32_t id : map.uploads) {
+        Tile_Chunk& chunk = map.chunks[id];
+        size_t bytes = chunk.mesh.size() * sizeof(float);
+        glBufferSubData(GL_ARRAY_BUFFER, chunk.slot * SLOT_BYTES, bytes, chunk.mesh.data());
+        chunk.uploaded_revision = chunk.built_revision;
+        chunk.uploaded_quads = chunk.quad_count;
+        frame_stats.bytes_uploaded += bytes;
+        frame_stats.buffer_updates++;
+
+        // The GPU copy is the one drawn, so the map keeps no mesh in memory
+        // for chunks it has already uploaded
+        std::vector<float>().swap(chunk.mesh);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Reads only what Upload_Tilemap wrote, so builds may still be running
+void Renderer::Submit_Tilemap(Render_Queue& queue, Shader_Handle shader, Tilemap& map, uint16_t layer) {
+    for (uint32_t id : map.visible) {
+        const Tile_Chunk& chunk = map.chunks[id];
+        if (chunk.slot < 0)
+            continue;
+
+        int first = chunk.slot * CHUNK_QUADS * QUAD_VERTEX_COUNT;
+        Submit_Vertices(queue, shader, map.vao, map.buffer, first, chunk.uploaded_quads * QUAD_VERTEX_COUNT, layer);
+    }
+}
\ No newline at end of file
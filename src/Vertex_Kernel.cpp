@@ -0,0 +1,210 @@
+#include "Vertex_Kernel.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VERTEX_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need the instruction set enabled per function; MSVC accepts
+// the intrinsics anywhere
+#if defined(__GNUC__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+#include <cstring>
+
+using Vertex_Kernel::QUAD_VERTEX_COUNT;
+using Vertex_Kernel::VERTEX_SIZE;
+using Vertex_Kernel::QUAD_SIZE;
+
+const glm::vec2 Vertex_Kernel::QUAD_CORNERS[QUAD_VERTEX_COUNT] = {
+    { -0.5f, -0.5f },
+    {  0.5f, -0.5f },
+    {  0.5f,  0.5f },
+    { -0.5f,  0.5f },
+};
+
+const uint32_t Vertex_Kernel::QUAD_INDICES[QUAD_INDEX_COUNT] = { 0, 1, 2, 0, 2, 3 };
+
+// NaN clamps to 0, matching _mm_max_ps with zero as the second operand
+static uint32_t Quantize(float channel) {
+    channel = channel > 0.0f ? channel : 0.0f;
+    channel = channel < 1.0f ? channel : 1.0f;
+    return (uint32_t) (channel * 255.0f + 0.5f);
+}
+
+uint32_t Vertex_Kernel::Pack_Color(const glm::vec3& tint) {
+    return Quantize(tint.x) | (Quantize(tint.y) << 8) | (Quantize(tint.z) << 16) | 0xFF000000u;
+}
+
+// Multiplies and adds are kept separate (no FMA) so the result rounds exactly
+// like glm's matrix * vector. Compilers may still fuse them on their own when
+// FMA is available (GCC does with -march=native), so this file is built with
+// -ffp-contract=off, see NOCONTRACT in the Makefile and the Vertex_Kernel.cpp
+// filter in premake5.lua.
+static void Transform_Quads_Scalar(const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints, int count, float* out) {
+    for (int q = 0; q < count; ++q) {
+        const glm::vec3& position = positions[q];
+        const glm::vec3& scale = scales[q];
+        uint32_t color = Vertex_Kernel::Pack_Color(tints[q]);
+
+        for (int v = 0; v < QUAD_VERTEX_COUNT; ++v) {
+            const glm::vec2& corner = Vertex_Kernel::QUAD_CORNERS[v];
+            out[0] = corner.x * scale.x + position.x;
+            out[1] = corner.y * scale.y + position.y;
+            std::memcpy(&out[2], &color, sizeof(color));
+            out += VERTEX_SIZE;
+        }
+    }
+}
+
+#ifdef VERTEX_KERNEL_X86
+KERNEL_TARGET("sse4.1")
+static __m128 Pack_Color_SSE(const glm::vec3& tint) {
+    __m128 channels = _mm_setr_ps(tint.x, tint.y, tint.z, 1.0f);
+    channels = _mm_min_ps(_mm_max_ps(channels, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    channels = _mm_add_ps(_mm_mul_ps(channels, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+
+    __m128i bytes = _mm_cvttps_epi32(channels);
+    bytes = _mm_packus_epi32(bytes, bytes);
+    bytes = _mm_packus_epi16(bytes, bytes);
+    return _mm_castsi128_ps(_mm_shuffle_epi32(bytes, 0));
+}
+
+// The four corners of a quad are transformed at once as (x0 x1 x2 x3) and
+// (y0 y1 y2 y3), then interleaved with the color into three 4-word stores:
+// (x0 y0 c x1) (y1 c x2 y2) (c x3 y3 c)
+KERNEL_TARGET("sse4.1")
+static void Transform_Quads_SSE(const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints, int count, float* out) {
+    const __m128 corners_x = _mm_setr_ps(Vertex_Kernel::QUAD_CORNERS[0].x, Vertex_Kernel::QUAD_CORNERS[1].x,
+                                         Vertex_Kernel::QUAD_CORNERS[2].x, Vertex_Kernel::QUAD_CORNERS[3].x);
+    const __m128 corners_y = _mm_setr_ps(Vertex_Kernel::QUAD_CORNERS[0].y, Vertex_Kernel::QUAD_CORNERS[1].y,
+                                         Vertex_Kernel::QUAD_CORNERS[2].y, Vertex_Kernel::QUAD_CORNERS[3].y);
+
+    for (int q = 0; q < count; ++q) {
+        __m128 x = _mm_add_ps(_mm_mul_ps(corners_x, _mm_set1_ps(scales[q].x)), _mm_set1_ps(positions[q].x));
+        __m128 y = _mm_add_ps(_mm_mul_ps(corners_y, _mm_set1_ps(scales[q].y)), _mm_set1_ps(positions[q].y));
+        __m128 color = Pack_Color_SSE(tints[q]);
+
+        __m128 low = _mm_unpacklo_ps(x, y);     // x0 y0 x1 y1
+        __m128 high = _mm_unpackhi_ps(x, y);    // x2 y2 x3 y3
+
+        __m128 first = _mm_blend_ps(_mm_shuffle_ps(low, color, _MM_SHUFFLE(0, 0, 1, 0)),
+                                    _mm_shuffle_ps(low, low, _MM_SHUFFLE(2, 2, 2, 2)), 0x8);
+        __m128 second = _mm_blend_ps(_mm_shuffle_ps(low, high, _MM_SHUFFLE(1, 0, 3, 3)), color, 0x2);
+        __m128 third = _mm_blend_ps(_mm_shuffle_ps(high, high, _MM_SHUFFLE(0, 3, 2, 0)), color, 0x9);
+
+        _mm_storeu_ps(out, first);
+        _mm_storeu_ps(out + 4, second);
+        _mm_storeu_ps(out + 8, third);
+        out += QUAD_SIZE;
+    }
+}
+
+// Two quads per 256-bit operation, one in each 128-bit lane. The shuffles
+// work within lanes, so each lane is interleaved exactly like the SSE path.
+KERNEL_TARGET("avx2")
+static void Transform_Quads_AVX2(const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints, int count, float* out) {
+    const __m128 corners_x = _mm_setr_ps(Vertex_Kernel::QUAD_CORNERS[0].x, Vertex_Kernel::QUAD_CORNERS[1].x,
+                                         Vertex_Kernel::QUAD_CORNERS[2].x, Vertex_Kernel::QUAD_CORNERS[3].x);
+    const __m128 corners_y = _mm_setr_ps(Vertex_Kernel::QUAD_CORNERS[0].y, Vertex_Kernel::QUAD_CORNERS[1].y,
+                                         Vertex_Kernel::QUAD_CORNERS[2].y, Vertex_Kernel::QUAD_CORNERS[3].y);
+    const __m256 corners_x2 = _mm256_set_m128(corners_x, corners_x);
+    const __m256 corners_y2 = _mm256_set_m128(corners_y, corners_y);
+
+    int q = 0;
+    for (; q + 2 <= count; q += 2) {
+        __m256 scale_x = _mm256_set_m128(_mm_set1_ps(scales[q + 1].x), _mm_set1_ps(scales[q].x));
+        __m256 scale_y = _mm256_set_m128(_mm_set1_ps(scales[q + 1].y), _mm_set1_ps(scales[q].y));
+        __m256 position_x = _mm256_set_m128(_mm_set1_ps(positions[q + 1].x), _mm_set1_ps(positions[q].x));
+        __m256 position_y = _mm256_set_m128(_mm_set1_ps(positions[q + 1].y), _mm_set1_ps(positions[q].y));
+        __m256 color = _mm256_set_m128(Pack_Color_SSE(tints[q + 1]), Pack_Color_SSE(tints[q]));
+
+        __m256 x = _mm256_add_ps(_mm256_mul_ps(corners_x2, scale_x), position_x);
+        __m256 y = _mm256_add_ps(_mm256_mul_ps(corners_y2, scale_y), position_y);
+
+        __m256 low = _mm256_unpacklo_ps(x, y);
+        __m256 high = _mm256_unpackhi_ps(x, y);
+
+        __m256 first = _mm256_blend_ps(_mm256_shuffle_ps(low, color, _MM_SHUFFLE(0, 0, 1, 0)),
+                                       _mm256_shuffle_ps(low, low, _MM_SHUFFLE(2, 2, 2, 2)), 0x88);
+        __m256 second = _mm256_blend_ps(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(1, 0, 3, 3)), color, 0x22);
+        __m256 third = _mm256_blend_ps(_mm256_shuffle_ps(high, high, _MM_SHUFFLE(0, 3, 2, 0)), color, 0x99);
+
+        _mm_storeu_ps(out, _mm256_castps256_ps128(first));
+        _mm_storeu_ps(out + 4, _mm256_castps256_ps128(second));
+        _mm_storeu_ps(out + 8, _mm256_castps256_ps128(third));
+        _mm_storeu_ps(out + 12, _mm256_extractf128_ps(first, 1));
+        _mm_storeu_ps(out + 16, _mm256_extractf128_ps(second, 1));
+        _mm_storeu_ps(out + 20, _mm256_extractf128_ps(third, 1));
+        out += 2 * QUAD_SIZE;
+    }
+
+    if (q < count)
+        Transform_Quads_SSE(positions + q, scales + q, tints + q, count - q, out);
+}
+
+static bool Cpu_Supports(Vertex_Kernel::Path path) {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (path == Vertex_Kernel::Path::AVX2)  return __builtin_cpu_supports("avx2");
+    if (path == Vertex_Kernel::Path::SSE)   return __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool has_sse41 = (info[2] & (1 << 19)) != 0;
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    if (path == Vertex_Kernel::Path::SSE)   return has_sse41;
+    if (path == Vertex_Kernel::Path::AVX2) {
+        __cpuidex(info, 7, 0);
+        bool has_avx2 = (info[1] & (1 << 5)) != 0;
+        // The OS must also save the upper halves of the ymm registers
+        return has_avx2 && has_osxsave && (_xgetbv(0) & 0x6) == 0x6;
+    }
+#endif
+    return path == Vertex_Kernel::Path::SCALAR;
+}
+#else
+static bool Cpu_Supports(Vertex_Kernel::Path path) {
+    return path == Vertex_Kernel::Path::SCALAR;
+}
+#endif
+
+static Vertex_Kernel::Path active_path = Vertex_Kernel::Best_Path();
+
+Vertex_Kernel::Path Vertex_Kernel::Best_Path() {
+    if (Cpu_Supports(Path::AVX2))   return Path::AVX2;
+    if (Cpu_Supports(Path::SSE))    return Path::SSE;
+    return Path::SCALAR;
+}
+
+Vertex_Kernel::Path Vertex_Kernel::Active_Path() {
+    return active_path;
+}
+
+void Vertex_Kernel::Set_Path(Path path) {
+    active_path = Cpu_Supports(path) ? path : Best_Path();
+}
+
+const char* Vertex_Kernel::Path_Name(Path path) {
+    switch (path) {
+        case Path::AVX2:    return "avx2";
+        case Path::SSE:     return "sse4.1";
+        default:            return "scalar";
+    }
+}
+
+void Vertex_Kernel::Transform_Quads(const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints, int count, float* out) {
+    switch (active_path) {
+#ifdef VERTEX_KERNEL_X86
+        case Path::AVX2:    Transform_Quads_AVX2(positions, scales, tints, count, out); break;
+        case Path::SSE:     Transform_Quads_SSE(positions, scales, tints, count, out); break;
+#endif
+        default:            Transform_Quads_Scalar(positions, scales, tints, count, out); break;
+    }
+}
\ No newline at end of file
@@ -6,8 +6,17 @@
 #include <iostream>
 #include <fstream>
 
+#include "Asset_Pack.hpp"
 #include "Renderer.hpp"
+#include "Render_Queue.hpp"
 #include "Entity.hpp"
+#include "Headless.hpp"
+#include "Entity_Store.hpp"
+#include "Job_System.hpp"
+#include "Profiler.hpp"
+#include "Text.hpp"
+#include "Texture_Atlas.hpp"
+#include "Physics.hpp"
 
 // ================================
 // Input Handling
@@ -16,6 +25,13 @@ struct Input {
     bool space_pressed;
     bool up_pressed;
     bool down_pressed;
+    bool graph_pressed;
+    bool trace_pressed;
+    bool save_pressed;
+    bool click_pressed;
+    bool click_released;
+    // In the ortho view's coordinates, y up
+    glm::vec2 cursor;
 } user_input;
 
 void keyboard_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
@@ -31,6 +47,24 @@ void keyboard_callback(GLFWwindow* window, int key, int scancode, int action, in
     if (key == GLFW_KEY_DOWN && action == GLFW_RELEASE) {
         user_input.down_pressed = true;
     }
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+        user_input.graph_pressed = true;
+    }
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+        user_input.trace_pressed = true;
+    }
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+        user_input.save_pressed = true;
+    }
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        user_input.click_pressed = true;
+    }
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
+        user_input.click_released = true;
+    }
 }
 // =================================
 
@@ -45,7 +79,56 @@ void debug_output_callback(GLenum source, GLenum type, GLuint id, GLenum severit
 constexpr int WINDOW_WIDTH = 800;
 constexpr int WINDOW_HEIGHT = 600;
 
-int main() {
+// Drags shorter than this on both axes are clicks
+constexpr float DRAG_THRESHOLD = 4.0f;
+constexpr float OUTLINE_WIDTH = 2.0f;
+
+// Textured sprites along the top right corner, one per atlas region
+const char* const ICON_NAMES[] = { "heart", "coin", "crate" };
+constexpr float ICON_SIZE = 32.0f;
+
+// Frames every selected entity with four thin quads
+void build_selection_outlines(const Entity_Store& entities, const std::vector<Entity_Handle>& selection, Renderer::Sprite_Batch& batch) {
+    batch.clear();
+
+    Sprite outline;
+    outline.tint = glm::vec3(1.0f, 0.85f, 0.0f);
+    for (Entity_Handle handle : selection) {
+        if (!entities.is_alive(handle))
+            continue;
+
+        uint32_t index = entities.index_of(handle);
+        glm::vec3 center = entities.position(index);
+        glm::vec3 half = glm::abs(entities.scale(index)) * 0.5f;
+        float width = half.x * 2.0f + OUTLINE_WIDTH;
+        float height = half.y * 2.0f + OUTLINE_WIDTH;
+        const glm::vec3 edges[4][2] = {
+            { center + glm::vec3(0.0f, half.y, 0.0f),  glm::vec3(width, OUTLINE_WIDTH, 1.0f) },
+            { center - glm::vec3(0.0f, half.y, 0.0f),  glm::vec3(width, OUTLINE_WIDTH, 1.0f) },
+            { center + glm::vec3(half.x, 0.0f, 0.0f),  glm::vec3(OUTLINE_WIDTH, height, 1.0f) },
+            { center - glm::vec3(half.x, 0.0f, 0.0f),  glm::vec3(OUTLINE_WIDTH, height, 1.0f) },
+        };
+        for (const auto& edge : edges) {
+            outline.update_buffer(edge[0], edge[1]);
+            batch.add(outline);
+        }
+    }
+}
+
+constexpr const char* ASSET_PACK_FILE = "assets.pack";
+constexpr const char* SCENE_FILE = "scene.pack";
+
+int main(int argc, char** argv) {
+    // Built by `make pack`; without it the loose files in assets/ are used
+    Asset_Pack::Pack asset_pack;
+    bool pack_mounted = std::ifstream(ASSET_PACK_FILE) && Asset_Pack::Open(asset_pack, ASSET_PACK_FILE);
+    if (pack_mounted)
+        Renderer::Mount_Pack(&asset_pack);
+
+    Headless::Options headless_options;
+    if (Headless::Parse_Arguments(argc, argv, headless_options))
+        return Headless::Run(headless_options);
+
     // ==============================
     // GLFW Initialize
     // ==============================
@@ -62,6 +145,7 @@ int main() {
     }
     
     glfwSetKeyCallback(window, keyboard_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     
     glfwMakeContextCurrent(window);
     // ===============================
@@ -75,39 +159,141 @@ int main() {
         glfwTerminate();
         return -1;
     }
+    Renderer::Load_Extensions((GLADloadproc) glfwGetProcAddress);
     
     glEnable(GL_DEBUG_OUTPUT);
     glDebugMessageCallback(debug_output_callback, (void*) 0);
     
     glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
     glClearColor(0.75f, 0.75f, 0.75f, 1.0f);
+    // Text edges are antialiased through alpha
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     bool is_mode_lines = false;
     // ===============================
 
     // Shader Creation
-    Renderer::Create_Shader("color");
-    //Renderer::Create_Shader("sprite");
+    Renderer::Shader_Handle color_shader = Renderer::Create_Shader("color");
+    Renderer::Shader_Handle text_shader = Renderer::Create_Shader("text");
+    Renderer::Shader_Handle sprite_shader = Renderer::Create_Shader("sprite");
+
+    // Cold starts compile every shader, warm starts load them from the cache
+    Renderer::Wait_Shaders();
+    printf("shader startup: %.2f ms (%d compiled, %d cached)\n",
+        Renderer::shader_stats.startup_ms, Renderer::shader_stats.compiled, Renderer::shader_stats.cache_hits);
 
     // ===============================
     // Setup screen-space transform
     // ===============================
-    glUseProgram(Renderer::shader_map["color"]);
+    glUseProgram(Renderer::Get_Shader(color_shader));
 
-    unsigned int ORTHO_TRANSFORM_LOCATION = glGetUniformLocation(Renderer::shader_map["color"], "ortho_transform");
+    unsigned int ORTHO_TRANSFORM_LOCATION = glGetUniformLocation(Renderer::Get_Shader(color_shader), "ortho_transform");
     glm::mat4 ortho_transform = glm::mat4(1.0f);
     ortho_transform = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f, 0.0f, -100.0f) * ortho_transform;
     glUniformMatrix4fv(ORTHO_TRANSFORM_LOCATION, 1, GL_FALSE, glm::value_ptr(ortho_transform));
 
+    glUseProgram(Renderer::Get_Shader(text_shader));
+    glUniformMatrix4fv(glGetUniformLocation(Renderer::Get_Shader(text_shader), "ortho_transform"), 1, GL_FALSE, glm::value_ptr(ortho_transform));
+
+    glUseProgram(Renderer::Get_Shader(sprite_shader));
+    glUniformMatrix4fv(glGetUniformLocation(Renderer::Get_Shader(sprite_shader), "ortho_transform"), 1, GL_FALSE, glm::value_ptr(ortho_transform));
+
     glUseProgram(0);
+
+    // F1 shows the frame graph, F2 saves a Chrome trace of the last frames
+    Profiler::Initialize(color_shader);
+    Profiler::Set_Thread_Name("main");
+    bool show_graph = false;
     // =============================
 
-    // Ideal entity creation code
-    Player player = Player(glm::vec3(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f));
-    // Text dialogue = Text(text);
-    // Solid wall = Solid(shape);
+    // The scene saved with F5, or the default one
+    Entity_Store entities;
+    Physics::World world;
+    std::vector<Solid> solids;
+    Asset_Pack::Pack scene_pack;
+    Asset_Pack::Scene_View saved_scene;
+    if (std::ifstream(SCENE_FILE) && Asset_Pack::Open(scene_pack, SCENE_FILE) && Asset_Pack::Get_Scene(scene_pack, "scene", saved_scene)) {
+        entities.load(saved_scene);
+        // Packs saved without bodies still load, but nothing in them moves
+        Asset_Pack::Bodies_View saved_bodies;
+        if (Asset_Pack::Get_Bodies(scene_pack, "scene", saved_bodies) && saved_bodies.entity_count == saved_scene.entity_count)
+            Load_Solids(saved_bodies, 0, world, entities, solids);
+        printf("loaded %d entities and %zu bodies from %s\n", entities.size(), solids.size(), SCENE_FILE);
+    }
+    else {
+        // Ideal entity creation code
+        entities.create(glm::vec3(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f), glm::vec3(100.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+
+        // A floor and a few crates falling onto it
+        glm::vec2 floor_size(WINDOW_WIDTH, 40.0f);
+        Entity_Handle floor = entities.create(glm::vec3(WINDOW_WIDTH / 2.0f, 20.0f, 0.0f), glm::vec3(floor_size, 1.0f), glm::vec3(0.3f));
+        solids.push_back({ floor, world.create_box(glm::vec2(WINDOW_WIDTH / 2.0f, 20.0f), floor_size * 0.5f, 0.0f) });
+        for (int i = 0; i < 12; ++i) {
+            glm::vec2 position(520.0f + (i % 4) * 50.0f + (i / 4) * 10.0f, 150.0f + (i / 4) * 60.0f);
+            Entity_Handle crate = entities.create(glm::vec3(position, 0.0f), glm::vec3(40.0f, 40.0f, 1.0f), glm::vec3(0.6f, 0.4f, 0.2f));
+            solids.push_back({ crate, world.create_box(position, glm::vec2(20.0f), 1.0f) });
+        }
+    }
+    Asset_Pack::Close(scene_pack);
+
+    Renderer::Sprite_Batch sprite_batch;
+    Renderer::Initialize_Batch("sprites", color_shader, sprite_batch, 1024);
+
+    // Collision shapes, drawn over the sprites in wireframe mode
+    Renderer::Sprite_Batch physics_batch;
+    Renderer::Initialize_Batch("physics_debug", color_shader, physics_batch, 1024);
+
+    // Clicking picks the entity on top, dragging selects every entity in the
+    // box; the selection is outlined over the sprites
+    std::vector<Entity_Handle> selection;
+    glm::vec2 drag_start(0.0f);
+    Renderer::Sprite_Batch selection_batch;
+    Renderer::Initialize_Batch("selection", color_shader, selection_batch, 64);
 
-    Renderer::Initialize_VAO("player", Renderer::shader_map["color"], player.sprite.buffer);
-    Renderer::Update_VAO_Buffer("player", player.sprite.buffer);
+    // Every string on screen goes out in one draw from the glyph atlas
+    Renderer::Glyph_Atlas glyph_atlas;
+    Renderer::Build_Glyph_Atlas(glyph_atlas);
+    Renderer::Upload_Glyph_Atlas(glyph_atlas);
+    Renderer::Sprite_Batch text_batch;
+    Renderer::Initialize_Batch("text", text_shader, text_batch, 1024, TEXTURED_SPRITE_FORMAT);
+    Renderer::Text_Cache text_cache;
+
+    Renderer::Text dialogue;
+    dialogue.string = "Space toggles wireframes, F1 the frame graph.\nF2 saves a trace, F5 the scene.\nClick or drag to select.";
+    dialogue.position = glm::vec2(16.0f, WINDOW_HEIGHT - 16.0f);
+    dialogue.size = 12.0f;
+    dialogue.color = glm::vec3(0.1f);
+    dialogue.max_width = WINDOW_WIDTH - 32.0f;
+    Renderer::Text lag_text;
+    lag_text.position = glm::vec2(16.0f, 40.0f);
+    lag_text.size = 16.0f;
+
+    Renderer::Render_Queue render_queue;
+
+    // The next frame is simulated on the job system while the main thread,
+    // which owns the GL context, submits the current one
+    Jobs::Initialize();
+    Jobs::Counter simulation;
+    std::vector<float> next_vertices;
+    bool next_changed = false;
+
+    // Every texture goes into one atlas, decoded on the job system or taken
+    // from the pack, so the textured sprites draw in one call
+    Renderer::Texture_Atlas atlas;
+    bool atlas_loaded = pack_mounted ? Renderer::Load_Atlas(atlas, asset_pack) : Renderer::Load_Atlas(atlas, "assets");
+    Renderer::Instance_Batch icon_batch;
+    Renderer::Initialize_Instanced("icons", sprite_shader, icon_batch, 16);
+    if (atlas_loaded) {
+        Transform transform;
+        transform.scale = glm::vec3(ICON_SIZE, ICON_SIZE, 1.0f);
+        Sprite icon;
+        transform.position = glm::vec3(WINDOW_WIDTH - ICON_SIZE, WINDOW_HEIGHT - ICON_SIZE, 0.0f);
+        for (const char* name : ICON_NAMES) {
+            icon.uv_rect = Renderer::Find_Region(atlas, name);
+            icon_batch.add(transform, icon);
+            transform.position.x -= ICON_SIZE;
+        }
+    }
 
     // =============================
     // GAME LOOP
@@ -116,22 +302,59 @@ int main() {
     float frame_t = 0.0f;
     float frame_rate = 1 / 60.0f;
     int lag = 1;
+#ifdef DEBUG
+    float stats_t = 0.0f;
+#endif
     while (!glfwWindowShouldClose(window)) {
-        // Reset single frame inputs
-        user_input.space_pressed = false;
-        user_input.down_pressed = false;
-        user_input.up_pressed = false;
+        Profiler::Begin_Frame();
+
+        {
+            PROFILE_ZONE("input");
 
-        glfwPollEvents();
+            // Reset single frame inputs
+            user_input.space_pressed = false;
+            user_input.down_pressed = false;
+            user_input.up_pressed = false;
+            user_input.graph_pressed = false;
+            user_input.trace_pressed = false;
+            user_input.save_pressed = false;
+            user_input.click_pressed = false;
+            user_input.click_released = false;
+
+            glfwPollEvents();
+
+            double cursor_x, cursor_y;
+            glfwGetCursorPos(window, &cursor_x, &cursor_y);
+            user_input.cursor = glm::vec2((float) cursor_x, WINDOW_HEIGHT - (float) cursor_y);
+        }
+
+        // The simulation job is done until the next submit, so the grid is
+        // safe to query here
+        if (user_input.click_pressed)
+            drag_start = user_input.cursor;
+        if (user_input.click_released) {
+            selection.clear();
+            glm::vec2 box_min = glm::min(drag_start, user_input.cursor);
+            glm::vec2 box_max = glm::max(drag_start, user_input.cursor);
+            if (box_max.x - box_min.x < DRAG_THRESHOLD && box_max.y - box_min.y < DRAG_THRESHOLD) {
+                Entity_Handle picked = entities.pick(user_input.cursor);
+                if (entities.is_alive(picked))
+                    selection.push_back(picked);
+            }
+            else {
+                entities.select(box_min, box_max, selection);
+            }
+            printf("selected %zu entities\n", selection.size());
+        }
 
         // Test code for modulating lag
         if (user_input.up_pressed)      printf("\nLAG: %d\n\n", ++lag);
         if (user_input.down_pressed)    printf("\nLAG: %d\n\n", --lag);
+        if (user_input.graph_pressed)   show_graph = !show_graph;
 
         // Timing
         float current_t = (float) glfwGetTime();
         float dt = current_t - prev_t;
-        //printf("%.3f\n", (float) dt);
         prev_t = current_t;
         if (dt > frame_rate * lag && lag > 0)
             dt = frame_rate * lag;
@@ -145,27 +368,115 @@ int main() {
         }
 
         // Update Loop
+        int update_steps = 0;
         while (frame_t > frame_rate) {
             frame_t -= frame_rate;
-
+            update_steps++;
         }
 
         // ===============================
         // RENDERING
         // ===============================
+        Renderer::Begin_Frame();
         glClear(GL_COLOR_BUFFER_BIT);
         
-        glUseProgram(Renderer::shader_map["color"]);
+        Renderer::Submit_Batch(render_queue, color_shader, sprite_batch, 0);
+
+        // The next sprites are built straight into the ring segment after the
+        // one just submitted, or into next_vertices when the ring has no room
+        float* next_mapped = Renderer::Map_Batch(sprite_batch, entities.size());
+        Jobs::Run(simulation, [&entities, &world, &solids, &next_vertices, &next_changed, next_mapped, frame_rate, update_steps] {
+            PROFILE_ZONE("update");
 
-        Renderer::Draw("player", player.sprite.buffer);
+            // Fixed-step entity updates
+            for (int step = 0; step < update_steps; ++step) {
+                world.step(frame_rate);
+            }
+            Sync_Solids(world, entities, solids);
 
-        glUseProgram(0);
+            // Only entities inside the ortho view are built and drawn. The view
+            // is fixed, so an unchanged scene reuses the last upload.
+            next_changed = entities.has_changes();
+            if (next_changed) {
+                entities.cull(glm::vec2(0.0f), glm::vec2(WINDOW_WIDTH, WINDOW_HEIGHT));
+                if (next_mapped)
+                    entities.build_visible_parallel(next_mapped);
+                else
+                    entities.build_visible_parallel(next_vertices);
+                entities.clear_changes();
+            }
+        });
 
+        if (is_mode_lines)
+            Renderer::Submit_Batch(render_queue, color_shader, physics_batch, 1);
+        Renderer::Submit_Batch(render_queue, color_shader, selection_batch, 1);
+        Renderer::Submit_Instanced(render_queue, sprite_shader, icon_batch, 1, atlas.texture);
 
-        glfwSwapBuffers(window);
+        // Layouts come from the cache until a string changes
+        lag_text.string = "LAG: " + std::to_string(lag);
+        text_batch.clear();
+        Renderer::Add_Text(text_batch, text_cache, glyph_atlas, dialogue);
+        Renderer::Add_Text(text_batch, text_cache, glyph_atlas, lag_text);
+        text_cache.end_frame();
+        Renderer::Submit_Batch(render_queue, text_shader, text_batch, Renderer::TEXT_LAYER, glyph_atlas.texture);
+        if (show_graph)
+            Profiler::Submit_Graph(render_queue);
+
+        Renderer::Flush_Queue(render_queue);
+
+#ifdef DEBUG
+        // Report batching once per second
+        stats_t += dt;
+        if (stats_t > 1.0f) {
+            stats_t = 0.0f;
+            Renderer::Frame_Stats& stats = Renderer::frame_stats;
+            printf("sprites: %d, commands: %d, draw calls: %d, program switches: %d, vao binds: %d\n",
+                sprite_batch.sprite_count, stats.commands, stats.draw_calls, stats.program_switches, stats.vao_binds);
+            printf("uploaded: %zu bytes in %d buffer updates, fence waits: %d\n", stats.bytes_uploaded, stats.buffer_updates, stats.fence_waits);
+        }
+#endif
+
+
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+        }
         // ===============================
+
+        {
+            PROFILE_ZONE("wait simulation");
+            Jobs::Wait(simulation);
+        }
+        sprite_batch.unchanged = !next_changed;
+        if (next_changed && next_mapped) {
+            Renderer::Commit_Batch(sprite_batch, entities.visible.size());
+        }
+        else if (next_changed) {
+            sprite_batch.buffer.stream.swap(next_vertices);
+            sprite_batch.sprite_count = entities.visible.size();
+        }
+        // Built with the sprites, so the shapes match them next frame
+        if (is_mode_lines)
+            world.build_debug_shapes(physics_batch);
+        build_selection_outlines(entities, selection, selection_batch);
+
+        Profiler::End_Frame();
+        // No jobs run between frames, so every thread's events are complete
+        if (user_input.trace_pressed && Profiler::Write_Trace("profile.json"))
+            printf("trace saved to profile.json\n");
+
+        if (user_input.save_pressed) {
+            Asset_Pack::Pack_Writer writer;
+            entities.save(writer, "scene");
+            Save_Solids(writer, "scene", world, entities, solids);
+            if (Asset_Pack::Write_Pack(writer, SCENE_FILE))
+                printf("saved %d entities to %s\n", entities.size(), SCENE_FILE);
+        }
     }
 
+    Jobs::Shutdown();
+    Asset_Pack::Close(asset_pack);
+
     glfwTerminate();
 
     return 0;
@@ -0,0 +1,25 @@
+#ifndef TEST_HPP
+#define TEST_HPP
+
+#include <cstdio>
+
+// Checks shared by the tests. A failed check prints where it failed and the
+// test keeps going, so one run reports every failure; Test_Result turns them
+// into the exit code.
+
+inline int test_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            test_failures++; \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+inline int Test_Result(const char* name) {
+    printf("%-24s %s\n", name, test_failures == 0 ? "passed" : "FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
+
+#endif
\ No newline at end of file
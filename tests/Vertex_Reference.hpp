@@ -0,0 +1,39 @@
+#ifndef VERTEX_REFERENCE_HPP
+#define VERTEX_REFERENCE_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "Vertex_Kernel.hpp"
+
+// The original per-vertex glm transform of Sprite::update_buffer, written in
+// SPRITE_FORMAT. Every Vertex_Kernel path must match it bit for bit; like the
+// kernel, it is built with -ffp-contract=off.
+inline void Transform_Quads_Glm(const glm::vec3* positions, const glm::vec3* scales, const glm::vec3* tints, int count, float* out) {
+    for (int q = 0; q < count; ++q) {
+        glm::mat4 matrix = glm::mat4(1.0f);
+        matrix = glm::translate(matrix, positions[q]);
+        matrix = glm::scale(matrix, scales[q]);
+
+        glm::vec3 tint = glm::clamp(tints[q], 0.0f, 1.0f);
+        uint8_t color[4] = {
+            (uint8_t) (tint.x * 255.0f + 0.5f),
+            (uint8_t) (tint.y * 255.0f + 0.5f),
+            (uint8_t) (tint.z * 255.0f + 0.5f),
+            255,
+        };
+
+        for (int v = 0; v < Vertex_Kernel::QUAD_VERTEX_COUNT; ++v) {
+            glm::vec3 transformed_position = matrix * glm::vec4(Vertex_Kernel::QUAD_CORNERS[v], 0.0f, 1.0f);
+            out[0] = transformed_position.x;
+            out[1] = transformed_position.y;
+            std::memcpy(&out[2], color, sizeof(color));
+            out += Vertex_Kernel::VERTEX_SIZE;
+        }
+    }
+}
+
+#endif
\ No newline at end of file
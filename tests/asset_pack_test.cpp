@@ -0,0 +1,177 @@
+// Asset_Pack round trip of every section type, then packs that are truncated
+// or corrupted, which must be rejected by Open or by the section getters
+// instead of being read out of bounds.
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Asset_Pack.hpp"
+#include "Test.hpp"
+
+constexpr uint32_t ENTITY_COUNT = 100;
+
+static std::vector<uint8_t> Read_File(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void Write_File(const std::string& filename, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write((const char*) bytes.data(), bytes.size());
+}
+
+// True when the bytes open as a pack whose scene, bodies, shader and texture
+// all read back
+static bool Reads_Back(const std::string& filename, const std::vector<uint8_t>& bytes) {
+    Write_File(filename, bytes);
+    Asset_Pack::Pack pack;
+    Asset_Pack::Scene_View scene;
+    Asset_Pack::Bodies_View bodies;
+    Asset_Pack::Texture_View texture;
+    std::string source;
+    bool read = Asset_Pack::Open(pack, filename)
+        && Asset_Pack::Get_Scene(pack, "scene", scene)
+        && Asset_Pack::Get_Bodies(pack, "scene", bodies)
+        && Asset_Pack::Get_Shader_Source(pack, "color.vert", source)
+        && Asset_Pack::Get_Texture(pack, "white", texture);
+    Asset_Pack::Close(pack);
+    return read;
+}
+
+int main() {
+    std::string filename = (std::filesystem::temp_directory_path() / "asset_pack_test.pack").string();
+
+    std::vector<glm::vec3> positions(ENTITY_COUNT);
+    std::vector<glm::vec3> scales(ENTITY_COUNT);
+    std::vector<glm::vec3> tints(ENTITY_COUNT);
+    std::vector<uint32_t> sprites(ENTITY_COUNT);
+    std::vector<float> masses(ENTITY_COUNT);
+    for (uint32_t e = 0; e < ENTITY_COUNT; ++e) {
+        positions[e] = glm::vec3(e * 1.5f, e * -0.25f, e / 7.0f);
+        scales[e] = glm::vec3(e + 1.0f, 2.0f, 1.0f);
+        tints[e] = glm::vec3(e / 100.0f, 0.5f, 1.0f);
+        sprites[e] = e % 3 == 0 ? Asset_Pack::NO_SPRITE : e % 2;
+        masses[e] = e % 4 == 0 ? Asset_Pack::NO_BODY : e * 0.5f;
+    }
+    std::vector<std::string> sprite_names = { "crate", "floor" };
+    std::string shader = "#version 430 core\nvoid main() {}\n";
+    std::vector<uint8_t> pixels = { 255, 255, 255, 255, 0, 0, 0, 255 };
+
+    Asset_Pack::Pack_Writer writer;
+    Asset_Pack::Add_Scene(writer, "scene", ENTITY_COUNT, positions.data(), scales.data(), tints.data(), sprites.data(), sprite_names);
+    Asset_Pack::Add_Bodies(writer, "scene", ENTITY_COUNT, masses.data());
+    Asset_Pack::Add_Shader(writer, "color.vert", shader);
+    Asset_Pack::Add_Texture(writer, "white", 2, 1, pixels.data());
+    CHECK(Asset_Pack::Write_Pack(writer, filename));
+
+    // Round trip, bit for bit
+    Asset_Pack::Pack pack;
+    CHECK(Asset_Pack::Open(pack, filename));
+    Asset_Pack::Scene_View scene;
+    CHECK(Asset_Pack::Get_Scene(pack, "scene", scene));
+    CHECK(scene.entity_count == ENTITY_COUNT);
+    if (scene.entity_count == ENTITY_COUNT) {
+        CHECK(std::memcmp(scene.positions, positions.data(), ENTITY_COUNT * sizeof(glm::vec3)) == 0);
+        CHECK(std::memcmp(scene.scales, scales.data(), ENTITY_COUNT * sizeof(glm::vec3)) == 0);
+        CHECK(std::memcmp(scene.tints, tints.data(), ENTITY_COUNT * sizeof(glm::vec3)) == 0);
+        CHECK(std::memcmp(scene.sprites, sprites.data(), ENTITY_COUNT * sizeof(uint32_t)) == 0);
+    }
+    CHECK(scene.sprite_name_count == 2);
+    if (scene.sprite_name_count == 2)
+        CHECK(std::string(scene.sprite_name(1)) == "floor");
+
+    Asset_Pack::Bodies_View bodies;
+    CHECK(Asset_Pack::Get_Bodies(pack, "scene", bodies));
+    CHECK(bodies.entity_count == ENTITY_COUNT);
+    if (bodies.entity_count == ENTITY_COUNT)
+        CHECK(std::memcmp(bodies.masses, masses.data(), ENTITY_COUNT * sizeof(float)) == 0);
+
+    std::string source;
+    CHECK(Asset_Pack::Get_Shader_Source(pack, "color.vert", source));
+    CHECK(source == shader);
+    Asset_Pack::Texture_View texture;
+    CHECK(Asset_Pack::Get_Texture(pack, "white", texture));
+    CHECK(texture.width == 2 && texture.height == 1);
+    if (texture.pixels)
+        CHECK(std::memcmp(texture.pixels, pixels.data(), pixels.size()) == 0);
+
+    // Missing sections, and sections asked for with the wrong type
+    CHECK(!Asset_Pack::Get_Scene(pack, "other", scene));
+    CHECK(!Asset_Pack::Get_Texture(pack, "scene", texture));
+    CHECK(!Asset_Pack::Get_Shader_Source(pack, "white", source));
+    Asset_Pack::Close(pack);
+    CHECK(pack.data == nullptr);
+
+    std::vector<uint8_t> bytes = Read_File(filename);
+    std::string corrupt_filename = filename + ".corrupt";
+    CHECK(Reads_Back(corrupt_filename, bytes));
+
+    // Every truncation, down to an empty file
+    for (size_t size : { (size_t) 0, (size_t) 3, sizeof(Asset_Pack::Header) - 1, sizeof(Asset_Pack::Header), bytes.size() / 2, bytes.size() - 1 })
+        CHECK(!Reads_Back(corrupt_filename, std::vector<uint8_t>(bytes.begin(), bytes.begin() + size)));
+
+    // Header fields
+    auto corrupted = [&](size_t offset, const void* value, size_t size) {
+        std::vector<uint8_t> copy = bytes;
+        std::memcpy(copy.data() + offset, value, size);
+        return copy;
+    };
+    const Asset_Pack::Header& header = *(const Asset_Pack::Header*) bytes.data();
+    uint32_t bad_version = Asset_Pack::VERSION + 1;
+    uint64_t bad_offset = bytes.size() + 64;
+    uint32_t many_sections = 1000000;
+    uint64_t odd_offset = header.table_offset + 1;
+    CHECK(!Reads_Back(corrupt_filename, corrupted(offsetof(Asset_Pack::Header, magic), "KCAP", 4)));
+    CHECK(!Reads_Back(corrupt_filename, corrupted(offsetof(Asset_Pack::Header, version), &bad_version, sizeof(bad_version))));
+    CHECK(!Reads_Back(corrupt_filename, corrupted(offsetof(Asset_Pack::Header, table_offset), &bad_offset, sizeof(bad_offset))));
+    CHECK(!Reads_Back(corrupt_filename, corrupted(offsetof(Asset_Pack::Header, table_offset), &odd_offset, sizeof(odd_offset))));
+    CHECK(!Reads_Back(corrupt_filename, corrupted(offsetof(Asset_Pack::Header, section_count), &many_sections, sizeof(many_sections))));
+
+    // Section entries: out of bounds, misaligned, oversized, unterminated name
+    for (uint32_t s = 0; s < header.section_count; ++s) {
+        size_t entry = header.table_offset + s * sizeof(Asset_Pack::Section);
+        const Asset_Pack::Section& section = *(const Asset_Pack::Section*) (bytes.data() + entry);
+        uint64_t past_end = bytes.size();
+        uint64_t misaligned = section.offset + 4;
+        uint64_t oversized = bytes.size() - section.offset + 1;
+        char long_name[Asset_Pack::MAX_NAME_LENGTH];
+        std::memset(long_name, 'x', sizeof(long_name));
+        CHECK(!Reads_Back(corrupt_filename, corrupted(entry + offsetof(Asset_Pack::Section, offset), &past_end, sizeof(past_end))));
+        CHECK(!Reads_Back(corrupt_filename, corrupted(entry + offsetof(Asset_Pack::Section, offset), &misaligned, sizeof(misaligned))));
+        CHECK(!Reads_Back(corrupt_filename, corrupted(entry + offsetof(Asset_Pack::Section, size), &oversized, sizeof(oversized))));
+        CHECK(!Reads_Back(corrupt_filename, corrupted(entry + offsetof(Asset_Pack::Section, name), long_name, sizeof(long_name))));
+    }
+
+    // Arrays inside the scene and bodies sections pointing past their end
+    for (uint32_t s = 0; s < header.section_count; ++s) {
+        size_t entry = header.table_offset + s * sizeof(Asset_Pack::Section);
+        const Asset_Pack::Section& section = *(const Asset_Pack::Section*) (bytes.data() + entry);
+        uint64_t past_section = section.size;
+        uint32_t too_many = UINT32_MAX;
+        if (section.type == Asset_Pack::SECTION_SCENE) {
+            CHECK(!Reads_Back(corrupt_filename, corrupted(section.offset + offsetof(Asset_Pack::Scene_Header, entity_count), &too_many, sizeof(too_many))));
+            CHECK(!Reads_Back(corrupt_filename, corrupted(section.offset + offsetof(Asset_Pack::Scene_Header, tints_offset), &past_section, sizeof(past_section))));
+            CHECK(!Reads_Back(corrupt_filename, corrupted(section.offset + offsetof(Asset_Pack::Scene_Header, names_offset), &past_section, sizeof(past_section))));
+            // The last name loses its terminator
+            std::vector<uint8_t> unterminated = bytes;
+            unterminated[section.offset + section.size - 1] = 'x';
+            CHECK(!Reads_Back(corrupt_filename, unterminated));
+        }
+        if (section.type == Asset_Pack::SECTION_BODIES) {
+            CHECK(!Reads_Back(corrupt_filename, corrupted(section.offset + offsetof(Asset_Pack::Bodies_Header, entity_count), &too_many, sizeof(too_many))));
+            CHECK(!Reads_Back(corrupt_filename, corrupted(section.offset + offsetof(Asset_Pack::Bodies_Header, masses_offset), &past_section, sizeof(past_section))));
+        }
+        if (section.type == Asset_Pack::SECTION_TEXTURE) {
+            uint32_t wide = 1u << 20;
+            CHECK(!Reads_Back(corrupt_filename, corrupted(section.offset + offsetof(Asset_Pack::Texture_Header, width), &wide, sizeof(wide))));
+        }
+    }
+
+    std::filesystem::remove(filename);
+    std::filesystem::remove(corrupt_filename);
+    return Test_Result("asset_pack_test");
+}
\ No newline at end of file
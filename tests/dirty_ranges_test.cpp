@@ -0,0 +1,113 @@
+// Dirty range bookkeeping of resident batches: Coalesce_Ranges merging at
+// RANGE_MERGE_GAP and widening the gap past MAX_UPLOAD_RANGES, and the switch
+// of Entity_Store::build_changes to a full rebuild once more than 1/16 of the
+// entities changed.
+
+#include <vector>
+
+#include "Renderer.hpp"
+#include "Entity_Store.hpp"
+#include "Test.hpp"
+
+using Renderer::Sprite_Range;
+
+static std::vector<Sprite_Range> Coalesced(std::vector<Sprite_Range> ranges) {
+    Renderer::Coalesce_Ranges(ranges);
+    return ranges;
+}
+
+static bool Equal(const std::vector<Sprite_Range>& a, const std::vector<Sprite_Range>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].first != b[i].first || a[i].count != b[i].count)
+            return false;
+    }
+    return true;
+}
+
+// Sorted, disjoint, and covering every sprite of `input`
+static bool Covers(const std::vector<Sprite_Range>& output, const std::vector<Sprite_Range>& input) {
+    for (size_t i = 1; i < output.size(); ++i) {
+        if (output[i].first < output[i - 1].first + output[i - 1].count)
+            return false;
+    }
+    for (const Sprite_Range& range : input) {
+        bool covered = false;
+        for (const Sprite_Range& merged : output)
+            covered = covered || (range.first >= merged.first && range.first + range.count <= merged.first + merged.count);
+        if (!covered)
+            return false;
+    }
+    return true;
+}
+
+// Entities whose dirty ranges build_changes reports after `changes` of them
+// changed
+static std::vector<Sprite_Range> Dirty_After(int entity_count, int changes) {
+    Entity_Store store;
+    std::vector<Entity_Handle> handles;
+    for (int e = 0; e < entity_count; ++e)
+        handles.push_back(store.create(glm::vec3(e * 10.0f, 0.0f, 0.0f), glm::vec3(8.0f), glm::vec3(1.0f)));
+    Renderer::Resident_Batch batch;
+    store.build_changes(batch);
+    batch.dirty.clear();
+
+    // Every other entity, so no two changes are neighbours
+    for (int c = 0; c < changes; ++c)
+        store.set_tint(handles[c * 2], glm::vec3(0.5f));
+    store.build_changes(batch);
+    return batch.dirty;
+}
+
+int main() {
+    const int GAP = Renderer::RANGE_MERGE_GAP;
+
+    CHECK(Coalesced({}).empty());
+    CHECK(Equal(Coalesced({ { 5, 3 } }), { { 5, 3 } }));
+
+    // Adjacent, overlapping and contained ranges become one, in any order
+    CHECK(Equal(Coalesced({ { 4, 4 }, { 0, 4 } }), { { 0, 8 } }));
+    CHECK(Equal(Coalesced({ { 0, 10 }, { 5, 10 } }), { { 0, 15 } }));
+    CHECK(Equal(Coalesced({ { 0, 10 }, { 2, 3 } }), { { 0, 10 } }));
+    CHECK(Equal(Coalesced({ { 2, 3 }, { 2, 3 } }), { { 2, 3 } }));
+
+    // A gap of exactly RANGE_MERGE_GAP sprites merges, one more does not
+    CHECK(Equal(Coalesced({ { 0, 2 }, { 2 + GAP, 2 } }), { { 0, 4 + GAP } }));
+    CHECK(Equal(Coalesced({ { 0, 2 }, { 3 + GAP, 2 } }), { { 0, 2 }, { 3 + GAP, 2 } }));
+    CHECK(Equal(Coalesced({ { 40, 1 }, { 0, 1 }, { 20, 1 } }), { { 0, 1 }, { 20, 1 }, { 40, 1 } }));
+
+    // MAX_UPLOAD_RANGES ranges too far apart to merge are kept as they are
+    std::vector<Sprite_Range> spread;
+    for (int r = 0; r < Renderer::MAX_UPLOAD_RANGES; ++r)
+        spread.push_back({ r * (GAP + 2), 1 });
+    CHECK(Equal(Coalesced(spread), spread));
+
+    // One more, and the gap doubles, which is enough to merge every range of
+    // this even spacing into one
+    int last = Renderer::MAX_UPLOAD_RANGES * (GAP + 2);
+    spread.push_back({ last, 1 });
+    CHECK(Equal(Coalesced(spread), { { 0, last + 1 } }));
+
+    // Far more ranges, at uneven spacing
+    std::vector<Sprite_Range> many;
+    int first = 0;
+    for (int r = 0; r < 5000; ++r) {
+        many.push_back({ first, 1 + r % 3 });
+        first += 5 + (r * 7919) % 200;
+    }
+    std::vector<Sprite_Range> merged = Coalesced(many);
+    CHECK(merged.size() <= (size_t) Renderer::MAX_UPLOAD_RANGES);
+    CHECK(Covers(merged, many));
+
+    // build_changes with 160 entities: 10 changes are exactly 1/16 and still
+    // built one by one, 11 rebuild everything
+    std::vector<Sprite_Range> dirty = Dirty_After(160, 10);
+    CHECK(dirty.size() == 10);
+    for (int c = 0; c < (int) dirty.size(); ++c)
+        CHECK(dirty[c].first == c * 2 && dirty[c].count == 1);
+    CHECK(Equal(Dirty_After(160, 11), { { 0, 160 } }));
+    CHECK(Dirty_After(160, 0).empty());
+
+    return Test_Result("dirty_ranges_test");
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+// Entity_Store handles: creation, destruction keeping the components dense,
+// and slot reuse bumping the generation so stale handles stay dead. Then
+// picking and box selection, which answer in draw order: sprites are built by
+// dense index, so the highest index is on top. Last, move_parallel, which
+// must keep the grid in step with the positions and mark only the entities
+// it actually moved.
+
+#include <algorithm>
+#include <vector>
+
+#include "Entity_Store.hpp"
+#include "Job_System.hpp"
+#include "Test.hpp"
+
+static bool Same(Entity_Handle a, Entity_Handle b) {
+    return a.slot == b.slot && a.generation == b.generation;
+}
+
+static void Check_Handles() {
+    Entity_Store store;
+    CHECK(store.size() == 0);
+    CHECK(!store.is_alive(Entity_Handle {}));
+
+    std::vector<Entity_Handle> handles;
+    for (int e = 0; e < 10; ++e)
+        handles.push_back(store.create(glm::vec3(e * 100.0f, 0.0f, 0.0f), glm::vec3(10.0f), glm::vec3(e / 10.0f)));
+    CHECK(store.size() == 10);
+    for (int e = 0; e < 10; ++e) {
+        CHECK(store.is_alive(handles[e]));
+        CHECK(store.index_of(handles[e]) == (uint32_t) e);
+        CHECK(Same(store.handle_of(e), handles[e]));
+    }
+
+    // The last entity moves into the hole, keeping its components
+    store.destroy(handles[3]);
+    CHECK(store.size() == 9);
+    CHECK(!store.is_alive(handles[3]));
+    CHECK(store.index_of(handles[9]) == 3);
+    CHECK(store.position(3) == glm::vec3(900.0f, 0.0f, 0.0f));
+    CHECK(store.tint(3) == glm::vec3(0.9f));
+    CHECK(Same(store.handle_of(3), handles[9]));
+    CHECK(store.has_changes());
+
+    // Destroying twice, or through a stale handle, does nothing
+    store.destroy(handles[3]);
+    CHECK(store.size() == 9);
+
+    // The freed slot is reused with a new generation, so the old handle
+    // stays dead and changes through it are ignored
+    Entity_Handle reused = store.create(glm::vec3(-50.0f, 0.0f, 0.0f), glm::vec3(10.0f), glm::vec3(1.0f));
+    CHECK(reused.slot == handles[3].slot);
+    CHECK(reused.generation != handles[3].generation);
+    CHECK(store.is_alive(reused) && !store.is_alive(handles[3]));
+    store.set_transform(handles[3], glm::vec3(5000.0f), glm::vec3(1.0f));
+    store.set_tint(handles[3], glm::vec3(0.0f));
+    CHECK(store.position(store.index_of(reused)) == glm::vec3(-50.0f, 0.0f, 0.0f));
+    CHECK(store.tint(store.index_of(reused)) == glm::vec3(1.0f));
+    CHECK(!store.is_alive(store.pick(glm::vec2(5000.0f))));
+    CHECK(Same(store.pick(glm::vec2(-50.0f, 0.0f)), reused));
+
+    // Destroying everything, in any order, leaves the store empty and the
+    // grid with nothing to find
+    for (int e : { 0, 9, 5, 1, 2, 4, 6, 7, 8 })
+        store.destroy(handles[e]);
+    store.destroy(reused);
+    CHECK(store.size() == 0);
+    std::vector<Entity_Handle> everything;
+    store.select(glm::vec2(-10000.0f), glm::vec2(10000.0f), everything);
+    CHECK(everything.empty());
+}
+
+int main() {
+    Check_Handles();
+
+    Entity_Store store;
+    glm::vec3 tint(1.0f);
+
+    // Three overlapping sprites, the last drawn on top; z plays no part
+    Entity_Handle bottom = store.create(glm::vec3(100.0f, 100.0f, 5.0f), glm::vec3(40.0f, 40.0f, 1.0f), tint);
+    Entity_Handle middle = store.create(glm::vec3(110.0f, 100.0f, 0.0f), glm::vec3(40.0f, 40.0f, 1.0f), tint);
+    Entity_Handle top = store.create(glm::vec3(120.0f, 100.0f, -5.0f), glm::vec3(40.0f, 40.0f, 1.0f), tint);
+    // Far wider than a grid cell
+    Entity_Handle floor = store.create(glm::vec3(400.0f, 20.0f, 0.0f), glm::vec3(800.0f, 40.0f, 1.0f), tint);
+
+    CHECK(Same(store.pick(glm::vec2(115.0f, 100.0f)), top));
+    CHECK(Same(store.pick(glm::vec2(95.0f, 100.0f)), middle));
+    CHECK(Same(store.pick(glm::vec2(82.0f, 100.0f)), bottom));
+    CHECK(Same(store.pick(glm::vec2(700.0f, 10.0f)), floor));
+    CHECK(!store.is_alive(store.pick(glm::vec2(500.0f, 500.0f))));
+
+    // Destroying moves the last entity into the hole, and with it its place
+    // in the draw order
+    store.destroy(top);
+    CHECK(Same(store.pick(glm::vec2(115.0f, 100.0f)), middle));
+    store.destroy(bottom);
+    CHECK(store.index_of(floor) == 0);
+    CHECK(Same(store.pick(glm::vec2(115.0f, 100.0f)), middle));
+    Entity_Handle cover = store.create(glm::vec3(110.0f, 100.0f, 0.0f), glm::vec3(10.0f, 10.0f, 1.0f), tint);
+    CHECK(Same(store.pick(glm::vec2(110.0f, 100.0f)), cover));
+
+    // Box selection finds every overlapping entity once
+    std::vector<Entity_Handle> selection;
+    store.select(glm::vec2(0.0f, 0.0f), glm::vec2(200.0f, 200.0f), selection);
+    CHECK(selection.size() == 3);
+    auto selected = [&selection](Entity_Handle handle) {
+        return std::any_of(selection.begin(), selection.end(), [handle](Entity_Handle other) { return Same(other, handle); });
+    };
+    CHECK(selected(middle) && selected(cover) && selected(floor));
+
+    selection.clear();
+    store.select(glm::vec2(300.0f, 300.0f), glm::vec2(400.0f, 400.0f), selection);
+    CHECK(selection.empty());
+
+    // Workers even on one core, so the jobs of move_parallel really overlap
+    Jobs::Initialize(3);
+    Entity_Store crowd;
+    constexpr int CROWD_SIZE = 5000;
+    for (int e = 0; e < CROWD_SIZE; ++e)
+        crowd.create(glm::vec3((e % 100) * 20.0f, (e / 100) * 20.0f, 0.0f), glm::vec3(e % 50 == 0 ? 300.0f : 8.0f), tint);
+    Renderer::Resident_Batch batch;
+    crowd.build_changes(batch);
+    CHECK(!crowd.has_changes());
+    batch.dirty.clear();
+
+    // One entity in 25, under the share that forces a full rebuild, steps far
+    // enough to cross cells, one way then back. Half of them are wider than a
+    // cell.
+    for (float step : { 150.0f, -150.0f }) {
+        crowd.move_parallel(64, [step](int first, int count, glm::vec3* positions) {
+            for (int e = first; e < first + count; ++e) {
+                if (e % 25 == 0)
+                    positions[e].x += step;
+            }
+        });
+
+        bool grid_matches = true;
+        for (int e = 0; e < CROWD_SIZE && grid_matches; ++e) {
+            glm::vec3 position = crowd.position(e);
+            std::vector<Entity_Handle> found;
+            crowd.select(glm::vec2(position.x, position.y), glm::vec2(position.x, position.y), found);
+            grid_matches = std::any_of(found.begin(), found.end(), [&](Entity_Handle handle) { return Same(handle, crowd.handle_of(e)); });
+        }
+        CHECK(grid_matches);
+
+        // Exactly the moved entities are rebuilt
+        crowd.build_changes(batch);
+        int dirty = 0;
+        bool only_moved = true;
+        for (const Renderer::Sprite_Range& range : batch.dirty) {
+            dirty += range.count;
+            only_moved = only_moved && range.count == 1 && range.first % 25 == 0;
+        }
+        CHECK(dirty == CROWD_SIZE / 25);
+        CHECK(only_moved);
+        batch.dirty.clear();
+    }
+
+    // A move that writes the same positions changes nothing
+    crowd.move_parallel(64, [](int first, int count, glm::vec3* positions) {
+        for (int e = first; e < first + count; ++e)
+            positions[e] = positions[e];
+    });
+    CHECK(!crowd.has_changes());
+    Jobs::Shutdown();
+
+    return Test_Result("entity_store_test");
+}
\ No newline at end of file
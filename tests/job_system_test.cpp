@@ -0,0 +1,115 @@
+// Job system: Parallel_For covering every index exactly once for any count
+// and grain, Run and Wait from several groups, jobs queuing more jobs, jobs
+// stolen by other threads, and the serial mode without workers.
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "Job_System.hpp"
+#include "Test.hpp"
+
+// Every index of [0, count) visited once, in slices no smaller than the
+// grain unless the whole range is
+static bool Covers_Once(int count, int grain) {
+    std::vector<std::atomic<int>> visits(count);
+    std::atomic<int> small_slices { 0 };
+    std::atomic<int> slices { 0 };
+    Jobs::Parallel_For(count, grain, [&](int first, int slice) {
+        slices++;
+        if (slice < grain && slice < count)
+            small_slices++;
+        for (int i = first; i < first + slice; ++i)
+            visits[i]++;
+    });
+
+    for (std::atomic<int>& visit : visits) {
+        if (visit != 1)
+            return false;
+    }
+    return (count == 0 || slices > 0) && slices <= Jobs::Thread_Count() && small_slices <= 1;
+}
+
+static void Check_Parallel_For() {
+    for (int count : { 0, 1, 2, 3, 7, 100, 4095, 4096, 4097, 100000 }) {
+        for (int grain : { 0, 1, 16, 4096 })
+            CHECK(Covers_Once(count, grain));
+    }
+}
+
+int main() {
+    // Without workers every job runs inline on the calling thread
+    Jobs::Initialize(0);
+    CHECK(Jobs::Thread_Count() == 1);
+    std::thread::id main_thread = std::this_thread::get_id();
+    Jobs::Counter inline_counter;
+    bool ran_inline = false;
+    Jobs::Run(inline_counter, [&] { ran_inline = std::this_thread::get_id() == main_thread; });
+    CHECK(ran_inline && inline_counter.pending == 0);
+    Check_Parallel_For();
+    Jobs::Shutdown();
+
+    // Workers even on one core
+    Jobs::Initialize(3);
+    CHECK(Jobs::Thread_Count() == 4);
+    Check_Parallel_For();
+
+    // Two groups waited on separately; the jobs of the first queue more jobs
+    // under the same counter
+    Jobs::Counter first_group;
+    Jobs::Counter second_group;
+    std::atomic<int> first_done { 0 };
+    std::atomic<int> second_done { 0 };
+    for (int j = 0; j < 100; ++j) {
+        Jobs::Run(first_group, [&] {
+            first_done++;
+            Jobs::Run(first_group, [&] { first_done++; });
+        });
+        Jobs::Run(second_group, [&] { second_done++; });
+    }
+    Jobs::Wait(first_group);
+    CHECK(first_done == 200);
+    CHECK(first_group.pending == 0);
+    Jobs::Wait(second_group);
+    CHECK(second_done == 100);
+
+    // Jobs queued by this thread are stolen by the workers while it is busy
+    // in one of them, so they run on more than one thread
+    Jobs::Counter stolen;
+    std::mutex thread_mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> started { 0 };
+    for (int j = 0; j < 64; ++j) {
+        Jobs::Run(stolen, [&] {
+            started++;
+            {
+                std::lock_guard<std::mutex> lock(thread_mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            // Hold the thread until some other job has started elsewhere
+            for (int spin = 0; spin < 1000 && started < 2; ++spin)
+                std::this_thread::yield();
+        });
+    }
+    Jobs::Wait(stolen);
+    CHECK(started == 64);
+    CHECK(threads.size() > 1);
+
+    // Nested Parallel_For from inside a job waits by running other jobs
+    Jobs::Counter outer;
+    std::atomic<int> inner_total { 0 };
+    for (int j = 0; j < 8; ++j) {
+        Jobs::Run(outer, [&] {
+            Jobs::Parallel_For(1000, 10, [&](int first, int count) { inner_total += count; });
+        });
+    }
+    Jobs::Wait(outer);
+    CHECK(inner_total == 8000);
+
+    Jobs::Shutdown();
+    CHECK(Jobs::Thread_Count() == 1);
+
+    return Test_Result("job_system_test");
+}
\ No newline at end of file
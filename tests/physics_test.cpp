@@ -0,0 +1,164 @@
+// Physics: the broadphase pairs against a brute force overlap test with and
+// without SSE, free fall, boxes and a polygon coming to rest on a static
+// floor, and bodies saved with a scene and loaded again.
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Physics.hpp"
+#include "Test.hpp"
+
+constexpr float DT = 1.0f / 60.0f;
+
+// Pairs of body ids, smaller first, sorted
+static std::vector<std::pair<uint32_t, uint32_t>> Found_Pairs(Physics::World& world) {
+    world.find_pairs();
+    std::vector<std::pair<uint32_t, uint32_t>> found;
+    for (size_t p = 0; p < world.pairs.size(); p += 2) {
+        uint32_t a = world.sweep_ids[world.pairs[p]];
+        uint32_t b = world.sweep_ids[world.pairs[p + 1]];
+        found.push_back({ std::min(a, b), std::max(a, b) });
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+static std::vector<std::pair<uint32_t, uint32_t>> Brute_Pairs(const Physics::World& world) {
+    std::vector<std::pair<uint32_t, uint32_t>> expected;
+    for (uint32_t a = 0; a < (uint32_t) world.size(); ++a) {
+        for (uint32_t b = a + 1; b < (uint32_t) world.size(); ++b) {
+            if (world.inverse_masses[a] == 0.0f && world.inverse_masses[b] == 0.0f)
+                continue;
+            glm::vec2 a_min = world.positions[a] + world.local_min[a];
+            glm::vec2 a_max = world.positions[a] + world.local_max[a];
+            glm::vec2 b_min = world.positions[b] + world.local_min[b];
+            glm::vec2 b_max = world.positions[b] + world.local_max[b];
+            if (a_min.x <= b_max.x && a_max.x >= b_min.x && a_min.y <= b_max.y && a_max.y >= b_min.y)
+                expected.push_back({ a, b });
+        }
+    }
+    return expected;
+}
+
+int main() {
+    // Broadphase, for every sweep path, after the bodies have moved and the
+    // sweep order is only nearly sorted
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> half(2.0f, 30.0f);
+    Physics::World scattered;
+    for (int b = 0; b < 1000; ++b)
+        scattered.create_box(glm::vec2(coordinate(rng), coordinate(rng)), glm::vec2(half(rng), half(rng)), b % 10 == 0 ? 0.0f : 1.0f);
+    for (int round = 0; round < 3; ++round) {
+        std::vector<std::pair<uint32_t, uint32_t>> expected = Brute_Pairs(scattered);
+        CHECK(!expected.empty());
+        for (bool simd : { true, false }) {
+            scattered.use_simd = simd;
+            CHECK(Found_Pairs(scattered) == expected);
+        }
+        for (glm::vec2& position : scattered.positions)
+            position += glm::vec2(half(rng) - 16.0f, half(rng) - 16.0f);
+    }
+
+    // Free fall from rest, integrating velocity before position
+    Physics::World falling;
+    uint32_t ball = falling.create_box(glm::vec2(0.0f, 1000.0f), glm::vec2(5.0f), 1.0f);
+    uint32_t anchor = falling.create_box(glm::vec2(500.0f, 0.0f), glm::vec2(5.0f), 0.0f);
+    for (int step = 0; step < 60; ++step)
+        falling.step(DT);
+    CHECK(std::fabs(falling.velocities[ball].y - falling.gravity.y) < 1e-2f);
+    CHECK(falling.velocities[ball].x == 0.0f && falling.positions[ball].x == 0.0f);
+    float expected_y = 1000.0f + falling.gravity.y * DT * DT * (60 * 61 / 2);
+    CHECK(std::fabs(falling.positions[ball].y - expected_y) < 1e-1f);
+    CHECK(falling.positions[anchor] == glm::vec2(500.0f, 0.0f));
+    CHECK(falling.velocities[anchor] == glm::vec2(0.0f));
+
+    // A stack of boxes and a triangle settle on a static floor, at rest and
+    // overlapping it by no more than the slop and a little solver error
+    Physics::World stack;
+    uint32_t floor = stack.create_box(glm::vec2(0.0f, -10.0f), glm::vec2(200.0f, 10.0f), 0.0f);
+    std::vector<uint32_t> boxes;
+    for (int b = 0; b < 4; ++b)
+        boxes.push_back(stack.create_box(glm::vec2(0.0f, 15.0f + b * 25.0f), glm::vec2(10.0f), 1.0f));
+    const glm::vec2 triangle[3] = { { -10.0f, -10.0f }, { 10.0f, -10.0f }, { 0.0f, 10.0f } };
+    uint32_t wedge = stack.create_polygon(glm::vec2(100.0f, 40.0f), triangle, 3, 1.0f);
+    for (int step = 0; step < 600; ++step)
+        stack.step(DT);
+
+    CHECK(stack.positions[floor] == glm::vec2(0.0f, -10.0f));
+    float tolerance = stack.slop + 0.5f;
+    for (int b = 0; b < 4; ++b) {
+        float bottom = stack.positions[boxes[b]].y - 10.0f;
+        CHECK(std::fabs(bottom - b * 20.0f) < tolerance);
+        CHECK(std::fabs(stack.positions[boxes[b]].x) < 1.0f);
+        CHECK(glm::length(stack.velocities[boxes[b]]) < 1.0f);
+    }
+    CHECK(std::fabs(stack.positions[wedge].y - 10.0f) < tolerance);
+    CHECK(glm::length(stack.velocities[wedge]) < 1.0f);
+
+    // Bodies saved with their scene, then loaded for the same entities
+    Entity_Store entities;
+    Physics::World world;
+    std::vector<Solid> solids;
+    Entity_Handle ground = entities.create(glm::vec3(400.0f, 20.0f, 0.0f), glm::vec3(800.0f, 40.0f, 1.0f), glm::vec3(0.3f));
+    solids.push_back({ ground, world.create_box(glm::vec2(400.0f, 20.0f), glm::vec2(400.0f, 20.0f), 0.0f) });
+    entities.create(glm::vec3(50.0f, 300.0f, 0.0f), glm::vec3(30.0f), glm::vec3(1.0f));
+    Entity_Handle crate = entities.create(glm::vec3(200.0f, 100.0f, 0.0f), glm::vec3(40.0f, 20.0f, 1.0f), glm::vec3(0.6f));
+    solids.push_back({ crate, world.create_box(glm::vec2(200.0f, 100.0f), glm::vec2(20.0f, 10.0f), 4.0f) });
+
+    std::string filename = (std::filesystem::temp_directory_path() / "physics_test.pack").string();
+    Asset_Pack::Pack_Writer writer;
+    entities.save(writer, "scene");
+    Save_Solids(writer, "scene", world, entities, solids);
+    CHECK(Asset_Pack::Write_Pack(writer, filename));
+
+    Asset_Pack::Pack pack;
+    Asset_Pack::Scene_View scene;
+    Asset_Pack::Bodies_View bodies;
+    CHECK(Asset_Pack::Open(pack, filename));
+    CHECK(Asset_Pack::Get_Scene(pack, "scene", scene));
+    CHECK(Asset_Pack::Get_Bodies(pack, "scene", bodies));
+
+    Entity_Store loaded_entities;
+    Physics::World loaded_world;
+    std::vector<Solid> loaded_solids;
+    loaded_entities.load(scene);
+    Load_Solids(bodies, 0, loaded_world, loaded_entities, loaded_solids);
+    Asset_Pack::Close(pack);
+    std::filesystem::remove(filename);
+
+    // The entity without a body gets none; the others keep their mass, and
+    // their boxes match their quads
+    CHECK(loaded_entities.size() == 3);
+    CHECK(loaded_solids.size() == 2 && loaded_world.size() == 2);
+    if (loaded_solids.size() == 2) {
+        for (const Solid& solid : loaded_solids) {
+            uint32_t index = loaded_entities.index_of(solid.entity);
+            glm::vec3 position = loaded_entities.position(index);
+            glm::vec3 scale = loaded_entities.scale(index);
+            CHECK(loaded_world.positions[solid.body] == glm::vec2(position.x, position.y));
+            CHECK(loaded_world.local_max[solid.body] == glm::vec2(scale.x, scale.y) * 0.5f);
+            CHECK(loaded_world.velocities[solid.body] == glm::vec2(0.0f));
+        }
+        CHECK(loaded_entities.index_of(loaded_solids[0].entity) == 0);
+        CHECK(loaded_world.inverse_masses[loaded_solids[0].body] == 0.0f);
+        CHECK(loaded_entities.index_of(loaded_solids[1].entity) == 2);
+        CHECK(loaded_world.inverse_masses[loaded_solids[1].body] == 0.25f);
+    }
+
+    // Loaded bodies move their entities like the originals
+    for (int step = 0; step < 30; ++step) {
+        world.step(DT);
+        loaded_world.step(DT);
+    }
+    Sync_Solids(world, entities, solids);
+    Sync_Solids(loaded_world, loaded_entities, loaded_solids);
+    CHECK(loaded_entities.position(2) == entities.position(entities.index_of(crate)));
+    CHECK(loaded_entities.position(0) == entities.position(entities.index_of(ground)));
+
+    return Test_Result("physics_test");
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Draw order of a Render_Queue, without a GL context: commands come out by
+// layer, then shader, texture and VAO, and commands with the same state keep
+// their submission order.
+
+#include <random>
+#include <vector>
+
+#include "Render_Queue.hpp"
+#include "Test.hpp"
+
+constexpr int COMMAND_COUNT = 5000;
+
+int main() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> layer(0, 3);
+    std::uniform_int_distribution<int> state(0, 5);
+
+    Vertex_Buffer buffer {};
+    buffer.primitive = GL_TRIANGLES;
+
+    // `first` records the submission order. Layers, shaders and VAOs use
+    // values spread over their whole key fields.
+    const uint16_t layers[] = { 0, 1, 0x0100, UINT16_MAX };
+    const uint32_t shaders[] = { 0, 1, 2, 0x0FF, 0x100, 0xFFF };
+    const uint32_t vaos[] = { 0, 1, 0xFF, 0x100, 0xFFFF, 0xFFFFF };
+    Renderer::Render_Queue queue;
+    for (int c = 0; c < COMMAND_COUNT; ++c) {
+        Renderer::Shader_Handle shader { shaders[state(rng)] };
+        Renderer::VAO_Handle vao { vaos[state(rng)] };
+        GLuint texture = state(rng) * 0x1111;
+        Renderer::Submit_Vertices(queue, shader, vao, buffer, c, 6, layers[layer(rng)], texture);
+    }
+    Renderer::Sort_Queue(queue);
+    CHECK(queue.sorted.size() == COMMAND_COUNT);
+
+    std::vector<bool> seen(COMMAND_COUNT, false);
+    for (size_t c = 0; c < queue.sorted.size(); ++c) {
+        const Renderer::Draw_Command& command = queue.sorted[c];
+        CHECK(!seen[command.first]);
+        seen[command.first] = true;
+        if (c == 0)
+            continue;
+
+        const Renderer::Draw_Command& previous = queue.sorted[c - 1];
+        uint16_t previous_layer = previous.key >> 48;
+        uint16_t current_layer = command.key >> 48;
+        CHECK(previous_layer <= current_layer);
+        CHECK(previous.key <= command.key);
+        if (previous_layer == current_layer && previous.shader.id != command.shader.id)
+            CHECK(previous.shader.id < command.shader.id);
+        if (previous.key == command.key)
+            CHECK(previous.first < command.first);
+    }
+
+    // Every command of a layer draws before any of the next
+    std::vector<int> layer_counts(4, 0);
+    for (const Renderer::Draw_Command& command : queue.sorted) {
+        int l = 0;
+        while (layers[l] != command.key >> 48)
+            ++l;
+        layer_counts[l]++;
+        for (int later = l + 1; later < 4; ++later)
+            CHECK(layer_counts[later] == 0);
+    }
+
+    // Equal keys only, so the order is the submission order
+    queue.clear();
+    for (int c = 0; c < 100; ++c)
+        Renderer::Submit_Vertices(queue, { 3 }, { 4 }, buffer, c, 6, 2, 5);
+    Renderer::Sort_Queue(queue);
+    for (int c = 0; c < 100; ++c)
+        CHECK(queue.sorted[c].first == c);
+
+    // Queued draws of a stream ring are counted until they are dropped
+    queue.clear();
+    Renderer::Stream_Ring ring;
+    Vertex_Buffer streamed {};
+    streamed.ring = &ring;
+    for (int c = 0; c < 3; ++c)
+        Renderer::Submit(queue, { 3 }, { 4 }, streamed, 0);
+    Renderer::Submit_Vertices(queue, { 3 }, { 4 }, buffer, 0, 6, 0);
+    CHECK(ring.queued_draws == 3);
+    queue.clear();
+    CHECK(ring.queued_draws == 0);
+
+    Renderer::Sort_Queue(queue);
+    CHECK(queue.sorted.empty());
+
+    return Test_Result("render_queue_test");
+}
\ No newline at end of file
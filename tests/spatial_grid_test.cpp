@@ -0,0 +1,121 @@
+// Spatial_Grid queries against a brute force scan of the same bounds, after
+// inserts, moves across cells and removals, with bounds both smaller and far
+// larger than a cell and moves that grow or shrink them past a cell.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Spatial_Grid.hpp"
+#include "Test.hpp"
+
+constexpr int ID_COUNT = 2000;
+constexpr float WORLD_SIZE = 4000.0f;
+
+struct Bounds {
+    glm::vec2 min;
+    glm::vec2 max;
+    bool alive = false;
+};
+
+static bool Overlaps(const Bounds& bounds, glm::vec2 min, glm::vec2 max) {
+    return bounds.min.x <= max.x && bounds.max.x >= min.x && bounds.min.y <= max.y && bounds.max.y >= min.y;
+}
+
+// The grid must return exactly the live ids overlapping the box, once each
+static bool Query_Matches(const Spatial_Grid& grid, const std::vector<Bounds>& bounds, glm::vec2 min, glm::vec2 max) {
+    std::vector<uint32_t> found;
+    grid.query(min, max, found);
+    std::sort(found.begin(), found.end());
+
+    std::vector<uint32_t> expected;
+    for (uint32_t id = 0; id < bounds.size(); ++id) {
+        if (bounds[id].alive && Overlaps(bounds[id], min, max))
+            expected.push_back(id);
+    }
+    return found == expected;
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coordinate(-WORLD_SIZE / 2.0f, WORLD_SIZE / 2.0f);
+    std::uniform_real_distribution<float> extent(1.0f, 40.0f);
+    std::uniform_real_distribution<float> step(-300.0f, 300.0f);
+
+    Spatial_Grid grid(128.0f);
+    std::vector<Bounds> bounds(ID_COUNT);
+    auto random_bounds = [&](glm::vec2 center, float scale) {
+        glm::vec2 half(extent(rng) * scale, extent(rng) * scale);
+        return Bounds { center - half, center + half, true };
+    };
+
+    // One id in a hundred is far larger than a cell
+    for (uint32_t id = 0; id < ID_COUNT; ++id) {
+        bounds[id] = random_bounds(glm::vec2(coordinate(rng), coordinate(rng)), id % 100 == 0 ? 20.0f : 1.0f);
+        grid.insert(id, bounds[id].min, bounds[id].max);
+    }
+    CHECK(grid.contains(0));
+    CHECK(!grid.contains(ID_COUNT));
+
+    std::vector<glm::vec4> boxes;
+    for (int b = 0; b < 50; ++b) {
+        glm::vec2 corner(coordinate(rng), coordinate(rng));
+        glm::vec2 size(extent(rng) * 20.0f, extent(rng) * 20.0f);
+        boxes.push_back(glm::vec4(corner.x, corner.y, corner.x + size.x, corner.y + size.y));
+    }
+    // A point, and a box over the whole world
+    boxes.push_back(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+    boxes.push_back(glm::vec4(-WORLD_SIZE, -WORLD_SIZE, WORLD_SIZE, WORLD_SIZE));
+
+    auto check_boxes = [&]() {
+        for (const glm::vec4& box : boxes)
+            CHECK(Query_Matches(grid, bounds, glm::vec2(box.x, box.y), glm::vec2(box.z, box.w)));
+    };
+    check_boxes();
+
+    // Moves, many of them into other cells and some growing past a cell or
+    // shrinking back, then removals
+    for (int round = 0; round < 5; ++round) {
+        for (uint32_t id = 0; id < ID_COUNT; id += 3) {
+            glm::vec2 center = (bounds[id].min + bounds[id].max) * 0.5f + glm::vec2(step(rng), step(rng));
+            bounds[id] = random_bounds(center, (id + round) % 50 == 0 ? 20.0f : 1.0f);
+            grid.move(id, bounds[id].min, bounds[id].max);
+        }
+        check_boxes();
+    }
+
+    for (uint32_t id = 0; id < ID_COUNT; id += 2) {
+        grid.remove(id);
+        bounds[id].alive = false;
+    }
+    CHECK(!grid.contains(0));
+    CHECK(grid.contains(1));
+    check_boxes();
+
+    // Removed ids can be inserted again
+    bounds[0] = random_bounds(glm::vec2(10.0f, 10.0f), 1.0f);
+    grid.insert(0, bounds[0].min, bounds[0].max);
+    CHECK(grid.contains(0));
+    check_boxes();
+
+    // Every cell key is a valid cell, (-1, -1) included
+    bounds[2] = random_bounds(glm::vec2(-10.0f, -10.0f), 0.1f);
+    grid.insert(2, bounds[2].min, bounds[2].max);
+    CHECK(grid.contains(2));
+    check_boxes();
+    bounds[2] = random_bounds(glm::vec2(-20.0f, -5.0f), 0.1f);
+    grid.move(2, bounds[2].min, bounds[2].max);
+    check_boxes();
+    grid.remove(2);
+    bounds[2].alive = false;
+    CHECK(!grid.contains(2));
+    check_boxes();
+
+    grid.clear();
+    CHECK(!grid.contains(1));
+    std::vector<uint32_t> found;
+    grid.query(glm::vec2(-WORLD_SIZE), glm::vec2(WORLD_SIZE), found);
+    CHECK(found.empty());
+
+    return Test_Result("spatial_grid_test");
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+// Text layout: glyph positions and indices, line breaks on '\n', words
+// wrapped whole at max_width, and the layout cache.
+
+#include <random>
+#include <string>
+
+#include "Text.hpp"
+#include "Test.hpp"
+
+constexpr float SIZE = 10.0f;
+
+static bool Quad_At(const Renderer::Glyph_Quad& quad, float x, float y, char character) {
+    return quad.min.x == x && quad.min.y == y && quad.max.x == x + SIZE && quad.max.y == y + SIZE
+        && quad.glyph == character - Renderer::FIRST_GLYPH;
+}
+
+int main() {
+    Renderer::Text_Layout layout;
+
+    Renderer::Layout_Text("", SIZE, 0.0f, layout);
+    CHECK(layout.quads.empty());
+    CHECK(layout.size.x == 0.0f && layout.size.y == 0.0f);
+
+    Renderer::Layout_Text("ab c", SIZE, 0.0f, layout);
+    CHECK(layout.quads.size() == 3);
+    if (layout.quads.size() == 3) {
+        CHECK(Quad_At(layout.quads[0], 0.0f, 0.0f, 'a'));
+        CHECK(Quad_At(layout.quads[1], 10.0f, 0.0f, 'b'));
+        CHECK(Quad_At(layout.quads[2], 30.0f, 0.0f, 'c'));
+    }
+    CHECK(layout.size.x == 40.0f && layout.size.y == 10.0f);
+
+    // Characters outside the font draw as '?'
+    Renderer::Layout_Text("\t\x80", SIZE, 0.0f, layout);
+    CHECK(layout.quads.size() == 2);
+    for (const Renderer::Glyph_Quad& quad : layout.quads)
+        CHECK(quad.glyph == '?' - Renderer::FIRST_GLYPH);
+
+    // Empty lines still take their height
+    Renderer::Layout_Text("ab\n\nc", SIZE, 0.0f, layout);
+    CHECK(layout.quads.size() == 3);
+    if (layout.quads.size() == 3)
+        CHECK(Quad_At(layout.quads[2], 0.0f, 20.0f, 'c'));
+    CHECK(layout.size.x == 20.0f && layout.size.y == 30.0f);
+
+    // The word that would cross max_width starts the next line
+    Renderer::Layout_Text("hello world", SIZE, 60.0f, layout);
+    CHECK(layout.quads.size() == 10);
+    if (layout.quads.size() == 10) {
+        CHECK(Quad_At(layout.quads[4], 40.0f, 0.0f, 'o'));
+        CHECK(Quad_At(layout.quads[5], 0.0f, 10.0f, 'w'));
+        CHECK(Quad_At(layout.quads[9], 40.0f, 10.0f, 'd'));
+    }
+    CHECK(layout.size.y == 20.0f);
+
+    // A word that fits exactly stays on the line
+    Renderer::Layout_Text("abc def", SIZE, 70.0f, layout);
+    CHECK(layout.size.y == 10.0f);
+
+    // Nor is a word wider than max_width split, or moved off an empty line
+    Renderer::Layout_Text("abcdefgh ij", SIZE, 30.0f, layout);
+    CHECK(layout.quads.size() == 10);
+    if (layout.quads.size() == 10) {
+        CHECK(Quad_At(layout.quads[7], 70.0f, 0.0f, 'h'));
+        CHECK(Quad_At(layout.quads[8], 0.0f, 10.0f, 'i'));
+    }
+    CHECK(layout.size.x == 90.0f && layout.size.y == 20.0f);
+
+    // No wrapping without max_width
+    Renderer::Layout_Text("hello world", SIZE, 0.0f, layout);
+    CHECK(layout.size.x == 110.0f && layout.size.y == 10.0f);
+
+    // Random words no wider than max_width: every glyph in order, inside
+    // max_width and the layout size, and words kept on one line
+    std::mt19937 random(77);
+    std::uniform_int_distribution<int> word_length(1, 8);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> separator(0, 9);
+    float max_width = 8 * SIZE;
+    for (int round = 0; round < 100; ++round) {
+        std::string text;
+        for (int word = 0; word < 40; ++word) {
+            for (int length = word_length(random); length > 0; --length)
+                text += (char) letter(random);
+            text += separator(random) == 0 ? '\n' : ' ';
+        }
+
+        Renderer::Layout_Text(text, SIZE, max_width, layout);
+        size_t quad = 0;
+        float word_y = -1.0f;
+        for (char character : text) {
+            if (character == ' ' || character == '\n') {
+                word_y = -1.0f;
+                continue;
+            }
+            if (quad == layout.quads.size())
+                break;
+            const Renderer::Glyph_Quad& glyph = layout.quads[quad++];
+            CHECK(glyph.glyph == character - Renderer::FIRST_GLYPH);
+            CHECK(glyph.max.x <= max_width && glyph.max.x <= layout.size.x && glyph.max.y <= layout.size.y);
+            if (word_y >= 0.0f)
+                CHECK(glyph.min.y == word_y);
+            word_y = glyph.min.y;
+        }
+        CHECK(quad == layout.quads.size());
+    }
+
+    // The cache lays a string out once per size and width, and drops entries
+    // unused for max_age frames
+    Renderer::Text_Cache cache;
+    cache.max_age = 2;
+    const Renderer::Text_Layout& cached = cache.get("hello world", SIZE, 60.0f);
+    CHECK(cached.size.y == 20.0f);
+    cache.get("hello world", SIZE, 60.0f);
+    CHECK(cache.misses == 1 && cache.hits == 1);
+    CHECK(cache.get("hello world", SIZE, 0.0f).size.y == 10.0f);
+    CHECK(cache.get("hello world", 2 * SIZE, 0.0f).size.y == 20.0f);
+    CHECK(cache.misses == 3 && cache.entries.size() == 3);
+    for (int frame = 0; frame < 3; ++frame)
+        cache.end_frame();
+    CHECK(cache.entries.empty());
+
+    return Test_Result("text_test");
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+// Tilemap bookkeeping without GL: tile storage and chunk revisions, chunk
+// meshes, and the slots Assign_Tilemap_Slots hands to chunks in view, as the
+// view moves and tiles are edited.
+
+#include <algorithm>
+#include <vector>
+
+#include "Tilemap.hpp"
+#include "Job_System.hpp"
+#include "Test.hpp"
+
+using Renderer::CHUNK_TILES;
+
+// One tile per unit, so chunk x spans [32x, 32x + 32)
+constexpr float CHUNK_SIZE = (float) CHUNK_TILES;
+
+// The part of Upload_Tilemap after the slots are assigned
+static void Upload(Renderer::Tilemap& map) {
+    for (uint32_t id : map.uploads) {
+        Renderer::Tile_Chunk& chunk = map.chunks[id];
+        chunk.uploaded_revision = chunk.built_revision;
+        chunk.uploaded_quads = chunk.quad_count;
+        std::vector<float>().swap(chunk.mesh);
+    }
+}
+
+// Views chunks [first_x, last_x] of the first row for a frame and returns
+// whether the pool grew
+static bool View_Chunks(Renderer::Tilemap& map, int first_x, int last_x) {
+    glm::vec2 view_min(first_x * CHUNK_SIZE, 0.0f);
+    glm::vec2 view_max((last_x + 1) * CHUNK_SIZE - 0.5f, CHUNK_SIZE - 0.5f);
+    Renderer::Update_Tilemap(map, view_min, view_max);
+    Jobs::Wait(map.builds);
+    bool grew = Renderer::Assign_Tilemap_Slots(map, map.uploads);
+    Upload(map);
+    return grew;
+}
+
+static void Fill_Chunk(Renderer::Tilemap& map, int chunk_x, uint16_t tile) {
+    for (int y = 0; y < CHUNK_TILES; ++y)
+        for (int x = 0; x < CHUNK_TILES; ++x)
+            map.set(chunk_x * CHUNK_TILES + x, y, tile);
+}
+
+// Every slot owned by at most one chunk, and every chunk's slot by it
+static bool Slots_Consistent(const Renderer::Tilemap& map) {
+    for (int s = 0; s < (int) map.slots.size(); ++s) {
+        if (map.slots[s] >= 0 && map.chunks[map.slots[s]].slot != s)
+            return false;
+    }
+    for (uint32_t id = 0; id < map.chunks.size(); ++id) {
+        int slot = map.chunks[id].slot;
+        if (slot >= 0 && (slot >= (int) map.slots.size() || map.slots[slot] != (int32_t) id))
+            return false;
+    }
+    return true;
+}
+
+int main() {
+    Jobs::Initialize();
+
+    Renderer::Tilemap map;
+    map.tile_size = 1.0f;
+    map.palette = { 0, 0xff0000ff, 0xff00ff00 };
+
+    // Sizes round up to whole chunks
+    map.resize(100, 70);
+    CHECK(map.chunks_x == 4 && map.chunks_y == 3);
+    CHECK(map.width == 128 && map.height == 96);
+    CHECK(map.tiles.size() == 128 * 96 && map.chunks.size() == 12);
+    CHECK(map.chunk_of(0, 0) == 0 && map.chunk_of(33, 0) == 1 && map.chunk_of(0, 32) == 4 && map.chunk_of(127, 95) == 11);
+    CHECK(map.chunk_of(-1, 0) == -1 && map.chunk_of(128, 0) == -1 && map.chunk_of(0, 96) == -1);
+
+    // Only a change bumps the chunk's revision; tiles outside are ignored
+    uint32_t revision = map.chunks[5].revision;
+    map.set(40, 40, 1);
+    CHECK(map.get(40, 40) == 1);
+    CHECK(map.chunks[5].revision == revision + 1);
+    map.set(40, 40, 1);
+    CHECK(map.chunks[5].revision == revision + 1);
+    map.set(-1, 40, 1);
+    map.set(40, 96, 1);
+    CHECK(map.get(-1, 40) == Renderer::EMPTY_TILE && map.get(40, 96) == Renderer::EMPTY_TILE);
+    for (const Renderer::Tile_Chunk& chunk : map.chunks)
+        CHECK(&chunk == &map.chunks[5] || chunk.revision == 1);
+
+    // Meshes skip empty tiles and ids past the palette
+    std::vector<float> mesh;
+    map.set(41, 40, 2);
+    map.set(42, 40, 7);
+    CHECK(Renderer::Build_Chunk_Mesh(map, 5, mesh) == 2);
+    CHECK(mesh.size() == 2 * Vertex_Kernel::QUAD_SIZE);
+    if (mesh.size() == 2 * Vertex_Kernel::QUAD_SIZE)
+        CHECK(mesh[0] == 40.0f && mesh[1] == 40.0f);
+    CHECK(Renderer::Build_Chunk_Mesh(map, 0, mesh) == 0 && mesh.empty());
+
+    // Two slots, and chunks 0 to 2 of the first row filled
+    map.resize(4 * CHUNK_TILES, CHUNK_TILES);
+    map.slots.assign(2, -1);
+    for (int chunk = 0; chunk < 3; ++chunk)
+        Fill_Chunk(map, chunk, 1);
+
+    CHECK(!View_Chunks(map, 0, 0));
+    CHECK(map.visible == std::vector<uint32_t>({ 0 }));
+    CHECK(map.uploads == std::vector<uint32_t>({ 0 }));
+    CHECK(map.chunks[0].slot >= 0 && map.chunks[0].uploaded_quads == Renderer::CHUNK_QUADS);
+    CHECK(map.chunks[0].mesh.empty());
+
+    // Nothing to upload while nothing changes
+    CHECK(!View_Chunks(map, 0, 0));
+    CHECK(map.uploads.empty());
+
+    CHECK(!View_Chunks(map, 0, 1));
+    CHECK(map.uploads == std::vector<uint32_t>({ 1 }));
+    CHECK(map.chunks[1].slot >= 0 && map.chunks[1].slot != map.chunks[0].slot);
+
+    // An edit uploads the chunk again into the slot it holds
+    int slot = map.chunks[1].slot;
+    map.set(CHUNK_TILES + 3, 3, 2);
+    CHECK(!View_Chunks(map, 1, 1));
+    CHECK(map.uploads == std::vector<uint32_t>({ 1 }));
+    CHECK(map.chunks[1].slot == slot);
+
+    // The pool is full, so chunk 2 takes the slot of chunk 0, out of view
+    // longer than chunk 1, which drops its mesh
+    slot = map.chunks[0].slot;
+    CHECK(!View_Chunks(map, 2, 2));
+    CHECK(map.uploads == std::vector<uint32_t>({ 2 }));
+    CHECK(map.chunks[2].slot == slot);
+    CHECK(map.chunks[0].slot == -1 && map.chunks[0].built_revision == 0 && map.chunks[0].quad_count == 0);
+    CHECK(map.chunks[1].slot >= 0);
+    CHECK(Slots_Consistent(map));
+
+    // A chunk edited down to no tiles gives its slot back
+    Fill_Chunk(map, 2, Renderer::EMPTY_TILE);
+    CHECK(!View_Chunks(map, 2, 2));
+    CHECK(map.uploads.empty());
+    CHECK(map.chunks[2].slot == -1 && map.slots[slot] == -1);
+
+    // Empty chunks in view need no slot
+    CHECK(!View_Chunks(map, 2, 3));
+    CHECK(map.uploads.empty());
+
+    // Three chunks with tiles in view need more than two slots. Growing the
+    // pool drops every slot, so chunk 1, whose mesh was freed after its
+    // upload, is built again and uploaded the frame after.
+    Fill_Chunk(map, 2, 2);
+    CHECK(View_Chunks(map, 0, 2));
+    CHECK(map.slots.size() >= 3);
+    std::vector<uint32_t> uploads = map.uploads;
+    std::sort(uploads.begin(), uploads.end());
+    CHECK(uploads == std::vector<uint32_t>({ 0, 2 }));
+    CHECK(map.chunks[1].slot == -1 && map.chunks[1].built_revision == 0);
+    CHECK(!View_Chunks(map, 0, 2));
+    CHECK(map.uploads == std::vector<uint32_t>({ 1 }));
+    for (int chunk = 0; chunk < 3; ++chunk)
+        CHECK(map.chunks[chunk].slot >= 0);
+    CHECK(Slots_Consistent(map));
+
+    // A view off the map sees nothing
+    Renderer::Update_Tilemap(map, glm::vec2(-100.0f, -100.0f), glm::vec2(-10.0f, -10.0f));
+    CHECK(map.visible.empty());
+
+    Jobs::Shutdown();
+    return Test_Result("tilemap_test");
+}
\ No newline at end of file
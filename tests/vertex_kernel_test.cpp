@@ -0,0 +1,70 @@
+// Every Vertex_Kernel path the CPU supports must produce the same bits as the
+// glm transform, for counts that leave tails after the SIMD loops and tints
+// outside [0, 1]. NaN tints are only checked through Pack_Color, since the
+// glm path converts them without a defined result.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Vertex_Kernel.hpp"
+#include "Test.hpp"
+#include "Vertex_Reference.hpp"
+
+constexpr int QUAD_COUNT = 10007;
+
+int main() {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coordinate(-4000.0f, 4000.0f);
+    std::uniform_real_distribution<float> size(0.1f, 300.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<glm::vec3> positions(QUAD_COUNT);
+    std::vector<glm::vec3> scales(QUAD_COUNT);
+    std::vector<glm::vec3> tints(QUAD_COUNT);
+    for (int q = 0; q < QUAD_COUNT; ++q) {
+        positions[q] = { coordinate(rng), coordinate(rng), unit(rng) * -50.0f };
+        scales[q] = { size(rng), size(rng), 1.0f };
+        tints[q] = { unit(rng) * 1.2f - 0.1f, unit(rng) * 1.2f - 0.1f, unit(rng) * 1.2f - 0.1f };
+    }
+    // Channels on the rounding edges, and ones the clamp must catch
+    tints[0] = { 0.0f, 1.0f, 0.5f / 255.0f };
+    tints[1] = { -1.0f, 2.0f, 1.0f / 255.0f };
+    tints[2] = { 127.5f / 255.0f, -0.0f, std::numeric_limits<float>::infinity() };
+    scales[3] = { -20.0f, 0.0f, 1.0f };
+
+    std::vector<float> reference(QUAD_COUNT * Vertex_Kernel::QUAD_SIZE);
+    Transform_Quads_Glm(positions.data(), scales.data(), tints.data(), QUAD_COUNT, reference.data());
+
+    const Vertex_Kernel::Path paths[] = { Vertex_Kernel::Path::SCALAR, Vertex_Kernel::Path::SSE, Vertex_Kernel::Path::AVX2 };
+    const int counts[] = { 0, 1, 2, 3, 7, 8, 9, QUAD_COUNT };
+    std::vector<float> output(reference.size() + Vertex_Kernel::QUAD_SIZE);
+    for (Vertex_Kernel::Path path : paths) {
+        Vertex_Kernel::Set_Path(path);
+        if (Vertex_Kernel::Active_Path() != path) {
+            printf("%s unsupported, skipped\n", Vertex_Kernel::Path_Name(path));
+            continue;
+        }
+
+        for (int count : counts) {
+            // The quad after the last must be left alone
+            std::fill(output.begin(), output.end(), -1.0f);
+            Vertex_Kernel::Transform_Quads(positions.data(), scales.data(), tints.data(), count, output.data());
+
+            size_t words = (size_t) count * Vertex_Kernel::QUAD_SIZE;
+            bool match = std::memcmp(output.data(), reference.data(), words * sizeof(float)) == 0;
+            if (!match)
+                printf("%s: %d quads differ from glm\n", Vertex_Kernel::Path_Name(path), count);
+            CHECK(match);
+            CHECK(output[words] == -1.0f);
+        }
+    }
+
+    CHECK(Vertex_Kernel::Pack_Color(glm::vec3(1.0f, 0.0f, 0.0f)) == 0xFF0000FFu);
+    float nan = std::numeric_limits<float>::quiet_NaN();
+    CHECK(Vertex_Kernel::Pack_Color(glm::vec3(nan, 2.0f, -1.0f)) == 0xFF00FF00u);
+
+    return Test_Result("vertex_kernel_test");
+}
\ No newline at end of file
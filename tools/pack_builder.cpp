@@ -0,0 +1,72 @@
+// Builds an asset pack from a directory: every .vert, .frag and .glsl file is
+// stored as shader source under its file name, and every .tga is decoded and
+// stored as RGBA8 under its file stem, so loading needs no decoding.
+//
+//   pack_builder <assets directory> <output.pack>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Asset_Pack.hpp"
+#include "Texture_Atlas.hpp"
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        printf("usage: %s <assets directory> <output.pack>\n", argv[0]);
+        return 1;
+    }
+
+    std::error_code error;
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1], error)) {
+        if (entry.is_regular_file())
+            files.push_back(entry.path());
+    }
+    if (error) {
+        printf("Failed to read %s: %s\n", argv[1], error.message().c_str());
+        return 1;
+    }
+    // Sorted so the same directory always gives the same pack
+    std::sort(files.begin(), files.end());
+
+    Asset_Pack::Pack_Writer writer;
+    int shader_count = 0;
+    int texture_count = 0;
+    for (const std::filesystem::path& path : files) {
+        std::string extension = path.extension().string();
+        std::string name = extension == ".tga" ? path.stem().string() : path.filename().string();
+        if (name.size() >= (size_t) Asset_Pack::MAX_NAME_LENGTH) {
+            printf("Skipping %s: name longer than %d characters\n", path.string().c_str(), Asset_Pack::MAX_NAME_LENGTH - 1);
+            continue;
+        }
+
+        if (extension == ".vert" || extension == ".frag" || extension == ".glsl") {
+            std::ifstream file(path, std::ios::binary);
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            Asset_Pack::Add_Shader(writer, name, contents.str());
+            shader_count++;
+        }
+        else if (extension == ".tga") {
+            Renderer::Image image;
+            if (!Renderer::Load_TGA(path.string(), image)) {
+                printf("Skipping %s: unsupported TGA\n", path.string().c_str());
+                continue;
+            }
+            Asset_Pack::Add_Texture(writer, name, image.width, image.height, image.pixels.data());
+            texture_count++;
+        }
+    }
+
+    if (!Asset_Pack::Write_Pack(writer, argv[2]))
+        return 1;
+
+    printf("%s: %d shaders, %d textures, %zu bytes\n", argv[2], shader_count, texture_count,
+        (size_t) std::filesystem::file_size(argv[2]));
+    return 0;
+}
\ No newline at end of file